@@ -62,6 +62,8 @@ struct GlobalMemory {
   long id;
   long *transtimes;
   long *totaltimes;
+  long *computetimes;
+  long *waittimes;
   unsigned long starttime;
   unsigned long finishtime;
   unsigned long initdonetime;
@@ -79,6 +81,7 @@ double *umain2;         /* umain2 is entire roots of unity matrix */
 long test_result = 0;
 long doprint = 0;
 long dostats = 0;
+long maxcomputestep = 0; /* longest computation step of all processes */
 /* long transtime = 0; AutoSync: there is no reason for this variable be global! */
 /* long transtime2 = 0; AutoSync: there is no reason for this variable be global! */
 /* long avgtranstime = 0; AutoSync: there is no reason for this variable be global! */
@@ -101,8 +104,10 @@ long pad_length;
 
 xAutoSyncIntentions xNoSpecialIntention;  
 xAutoSyncIntentions xConstantInitByMain = {.bConstantInitByMain = true};
-xAutoSyncIntentions xIntentionTransTimes = {.pvDependsOn[0] = &P}; /* Sliced Array!*/
-xAutoSyncIntentions xIntentionTotalTimes = {.pvDependsOn[0] = &P}; /* Sliced Array!*/
+xAutoSyncIntentions xIntentionTransTimes = {.bSlicedArray = true, .pvDependsOn[0] = &P};
+xAutoSyncIntentions xIntentionTotalTimes = {.bSlicedArray = true, .pvDependsOn[0] = &P};
+xAutoSyncIntentions xIntentionComputeTimes = {.bSlicedArray = true, .pvDependsOn[0] = &P};
+xAutoSyncIntentions xIntentionWaitTimes = {.bSlicedArray = true, .pvDependsOn[0] = &P};
 xAutoSyncIntentions xIntentionN = {.bConstantInitByMain = true, .pvDependsOn[0] = &M};
 xAutoSyncIntentions xIntentionX = {.pvDependsOn[0] = &N, .pvDependsOn[1] = &rootN, .pvDependsOn[2] = &pad_length};
 xAutoSyncIntentions xIntentionTrans = {.pvDependsOn[0] = &N, .pvDependsOn[1] = &rootN, .pvDependsOn[2] = &pad_length};
@@ -110,17 +115,11 @@ xAutoSyncIntentions xIntentionUmain2 = {.bConstantInitByMain = true, .pvDependsO
 xAutoSyncIntentions xIntentionUmain = {.bConstantInitByMain = true, .pvDependsOn[0] = &rootN};
 xAutoSyncIntentions xIntentionRootN = {.bConstantInitByMain = true, .pvDependsOn[0] = &M };
 
-xAutoSyncEvent xTwiddleDone;
+xAutoSyncEvent xTwiddleDone = AUTO_SYNC_BARRIER_SENSE_REVERSING;
 xAutoSyncEvent xFFT1DDone;
 xAutoSyncEvent xFFTDone;
 xAutoSyncEvent xTransposeDone;
 
-xAutoSyncIntentions xIntentionSlicedArray = {.bSlicedArray = true, 
-                                            uiFirstAccess = 0,
-                                            uiLastAccess  = 0 };
-
-iAutoSyncRead(&uiLocalVar, &uiSlicedArray, xIntentionSlicedArray);
-
 void SlaveStart(void);
 double TouchArray(double *x, double *scratch, double *u, double *upriv, long MyFirst, long MyLast);
 double CheckSum(double *x);
@@ -129,7 +128,8 @@ void InitU(long N, double *u);
 void InitU2(long N, double *u, long n1);
 long BitReverse(long M, long k);
 void FFT1D(long direction, long M, long N, double *x, double *scratch, double *upriv, double *umain2,
-	   long MyNum, long *l_transtime, long MyFirst, long MyLast, long pad_length, long test_result, long dostats);
+	   long MyNum, long *l_transtime, long *l_computetime, long *l_waittime, long MyFirst, long MyLast,
+	   long pad_length, long test_result, long dostats);
 void TwiddleOneCol(long direction, long n1, long j, double *u, double *x, long pad_length);
 void Scale(long n1, long N, double *x);
 void Transpose(long n1, double *src, double *dest, long MyNum, long MyFirst, long MyLast, long pad_length);
@@ -170,9 +170,16 @@ int main(int argc, char *argv[])
   long totaltime = 0;
   long transtime2 = 0;
   long avgtranstime = 0;
+  long computetime = 0;
+  long computetime2 = 0;
+  long avgcomputetime = 0;
+  long waittime = 0;
+  long waittime2 = 0;
+  long avgwaittime = 0;
   long avgcomptime = 0;
   long maxtotal=0;
   long mintotal=0;
+  long local_maxcomputestep;
   double maxfrac=0;
   double minfrac=0;
   double avgfractime=0;
@@ -343,6 +350,8 @@ int main(int argc, char *argv[])
 
   long* local_ptranstimes;
   long* local_ptotaltimes;
+  long* local_pcomputetimes;
+  long* local_pwaittimes;
 
   local_ptranstimes = (long *) G_MALLOC(P*sizeof(long));
   iAutoSyncWrite(&Global->transtimes, &local_ptranstimes, sizeof(local_ptranstimes), xIntentionTransTimes);
@@ -350,6 +359,12 @@ int main(int argc, char *argv[])
   local_ptotaltimes = (long *) G_MALLOC(P*sizeof(long));
   iAutoSyncWrite(&Global->totaltimes, &local_ptotaltimes, sizeof(local_ptotaltimes), xIntentionTotalTimes);
 
+  local_pcomputetimes = (long *) G_MALLOC(P*sizeof(long));
+  iAutoSyncWrite(&Global->computetimes, &local_pcomputetimes, sizeof(local_pcomputetimes), xIntentionComputeTimes);
+
+  local_pwaittimes = (long *) G_MALLOC(P*sizeof(long));
+  iAutoSyncWrite(&Global->waittimes, &local_pwaittimes, sizeof(local_pwaittimes), xIntentionWaitTimes);
+
   iAutoSyncRead(&local_pGlobal, &Global, sizeof(Global), xNoSpecialIntention);
   iAutoSyncRead(&local_px, &x, sizeof(x), xIntentionX);
   iAutoSyncRead(&local_ptrans, &trans, sizeof(trans), xIntentionTrans);
@@ -494,15 +509,17 @@ int main(int argc, char *argv[])
   }
 
 
-  iAutoSyncRead(&Global->transtimes[0], &transtime, sizeof(transtime), xNoSpecialIntention);
-  iAutoSyncRead(&Global->totaltimes[0], &totaltime, sizeof(totaltime), xNoSpecialIntention);
+  iAutoSyncRead(&transtime, &Global->transtimes[0], sizeof(transtime), xIntentionTransTimes);
+  iAutoSyncRead(&totaltime, &Global->totaltimes[0], sizeof(totaltime), xIntentionTotalTimes);
+  iAutoSyncRead(&computetime, &Global->computetimes[0], sizeof(computetime), xIntentionComputeTimes);
+  iAutoSyncRead(&waittime, &Global->waittimes[0], sizeof(waittime), xIntentionWaitTimes);
   printf("\n");
-  printf("                 PROCESS STATISTICS\n");
-  printf("            Computation      Transpose     Transpose\n");
-  printf(" Proc          Time            Time        Fraction\n");
-  printf("    0        %10ld     %10ld      %8.5f\n",
+  printf("                 PROCESS STATISTICS (ns)\n");
+  printf("            Computation      Transpose     Transpose            FFT           Wait\n");
+  printf(" Proc          Time            Time        Fraction            Time           Time\n");
+  printf("    0        %10ld     %10ld      %8.5f     %10ld     %10ld\n",
          totaltime, transtime,
-         ((double)transtime)/totaltime);
+         ((double)transtime)/totaltime, computetime, waittime);
   iAutoSyncRead(&local_dostats, &dostats, sizeof(dostats), xConstantInitByMain);
   if (local_dostats) {
     transtime2 = transtime;
@@ -513,6 +530,10 @@ int main(int argc, char *argv[])
     maxfrac = ((double)transtime)/totaltime;
     minfrac = ((double)transtime)/totaltime;
     avgfractime = ((double)transtime)/totaltime;
+    computetime2 = computetime;
+    avgcomputetime = computetime;
+    waittime2 = waittime;
+    avgwaittime = waittime;
     
     iAutoSyncRead(&localP, &P, sizeof(P), xConstantInitByMain);
     iAutoSyncRead(&local_pGlobal, &Global, sizeof(Global), xNoSpecialIntention);
@@ -535,19 +556,35 @@ int main(int argc, char *argv[])
       if (((double)local_pGlobal->transtimes[i])/local_pGlobal->totaltimes[i] < minfrac) {
         minfrac = ((double)local_pGlobal->transtimes[i])/local_pGlobal->totaltimes[i];
       }
-      printf("  %3ld        %10ld     %10ld      %8.5f\n",
+      if (local_pGlobal->computetimes[i] > computetime) {
+        computetime = local_pGlobal->computetimes[i];
+      }
+      if (local_pGlobal->computetimes[i] < computetime2) {
+        computetime2 = local_pGlobal->computetimes[i];
+      }
+      if (local_pGlobal->waittimes[i] > waittime) {
+        waittime = local_pGlobal->waittimes[i];
+      }
+      if (local_pGlobal->waittimes[i] < waittime2) {
+        waittime2 = local_pGlobal->waittimes[i];
+      }
+      printf("  %3ld        %10ld     %10ld      %8.5f     %10ld     %10ld\n",
              i,local_pGlobal->totaltimes[i],local_pGlobal->transtimes[i],
-             ((double)local_pGlobal->transtimes[i])/local_pGlobal->totaltimes[i]);
+             ((double)local_pGlobal->transtimes[i])/local_pGlobal->totaltimes[i],
+             local_pGlobal->computetimes[i],local_pGlobal->waittimes[i]);
       avgtranstime += local_pGlobal->transtimes[i];
       avgcomptime += local_pGlobal->totaltimes[i];
       avgfractime += ((double)local_pGlobal->transtimes[i])/local_pGlobal->totaltimes[i];
+      avgcomputetime += local_pGlobal->computetimes[i];
+      avgwaittime += local_pGlobal->waittimes[i];
     }
-    printf("  Avg        %10.0f     %10.0f      %8.5f\n",
-           ((double) avgcomptime)/P,((double) avgtranstime)/localP,avgfractime/localP);
-    printf("  Max        %10ld     %10ld      %8.5f\n",
-	   maxtotal,transtime,maxfrac);
-    printf("  Min        %10ld     %10ld      %8.5f\n",
-	   mintotal,transtime2,minfrac);
+    printf("  Avg        %10.0f     %10.0f      %8.5f     %10.0f     %10.0f\n",
+           ((double) avgcomptime)/P,((double) avgtranstime)/localP,avgfractime/localP,
+           ((double) avgcomputetime)/localP,((double) avgwaittime)/localP);
+    printf("  Max        %10ld     %10ld      %8.5f     %10ld     %10ld\n",
+	   maxtotal,transtime,maxfrac,computetime,waittime);
+    printf("  Min        %10ld     %10ld      %8.5f     %10ld     %10ld\n",
+	   mintotal,transtime2,minfrac,computetime2,waittime2);
   }
   local_pGlobal->starttime = start;
   printf("\n");
@@ -566,6 +603,9 @@ int main(int argc, char *argv[])
          transtime);
   printf("Overall transpose fraction        : %16.5f\n",
          ((double) transtime)/(local_pGlobal->finishtime-local_pGlobal->initdonetime));
+  iAutoSyncRead(&local_maxcomputestep, &maxcomputestep, sizeof(maxcomputestep), xNoSpecialIntention);
+  printf("Longest computation step          : %16ld\n",
+         local_maxcomputestep);
   printf("\n");
   
   iAutoSyncRead(&local_test_result, &test_result, sizeof(test_result), xConstantInitByMain);
@@ -598,6 +638,8 @@ void SlaveStart()
   long initdone;
   long finish;
   long l_transtime=0;
+  long l_computetime=0;
+  long l_waittime=0;
   long MyFirst;
   long MyLast;
   long localrootN;
@@ -656,7 +698,7 @@ void SlaveStart()
   iAutoSyncSharedVarAsArg(&pad_length);
   iAutoSyncSharedVarAsArg(&test_result);
   iAutoSyncSharedVarAsArg(&dostats);
-  FFT1D(1, M, N, x, trans, upriv, umain2, MyNum, &l_transtime, MyFirst,
+  FFT1D(1, M, N, x, trans, upriv, umain2, MyNum, &l_transtime, &l_computetime, &l_waittime, MyFirst,
 	MyLast, pad_length, test_result, dostats);  
 
   iAutoSyncRead(&local_test_result, &test_result, sizeof(test_result), xConstantInitByMain);
@@ -670,7 +712,7 @@ void SlaveStart()
     iAutoSyncSharedVarAsArg(&pad_length);
     iAutoSyncSharedVarAsArg(&test_result);
     iAutoSyncSharedVarAsArg(&dostats);
-    FFT1D(-1, M, N, x, trans, upriv, umain2, MyNum, &l_transtime, MyFirst,
+    FFT1D(-1, M, N, x, trans, upriv, umain2, MyNum, &l_transtime, &l_computetime, &l_waittime, MyFirst,
 	  MyLast, pad_length, test_result, dostats);
   }
 
@@ -678,6 +720,8 @@ void SlaveStart()
   if ((MyNum == 0) || (local_dostats)) {
     CLOCK(finish);
     iAutoSyncWrite(&Global->transtimes[MyNum], &l_transtime, sizeof(l_transtime), xIntentionTransTimes);
+    iAutoSyncWrite(&Global->computetimes[MyNum], &l_computetime, sizeof(l_computetime), xIntentionComputeTimes);
+    iAutoSyncWrite(&Global->waittimes[MyNum], &l_waittime, sizeof(l_waittime), xIntentionWaitTimes);
 
     local_timediff= finish-initdone;
     iAutoSyncWrite(&Global->totaltimes[MyNum], &local_timediff, sizeof(local_timediff), xIntentionTotalTimes);    
@@ -795,13 +839,16 @@ long BitReverse(long M, long k)
 
 
 void FFT1D(long direction, long M, long N, double *x, double *scratch, double *upriv, double *umain2,
-           long MyNum, long *l_transtime, long MyFirst, long MyLast, long pad_length, long test_result, long dostats)
+           long MyNum, long *l_transtime, long *l_computetime, long *l_waittime, long MyFirst, long MyLast,
+           long pad_length, long test_result, long dostats)
 {
   long j;
   long m1;
   long n1;
   unsigned long clocktime1;
   unsigned long clocktime2;
+  unsigned long clocktime3;
+  long computestep;
 
   m1 = M/2;
   n1 = 1<<m1;
@@ -827,11 +874,20 @@ void FFT1D(long direction, long M, long N, double *x, double *scratch, double *u
     TwiddleOneCol(direction, n1, j, umain2, &scratch[2*j*(n1+pad_length)], pad_length);
   }
 
+  if ((MyNum == 0) || (dostats)) {
+    CLOCK(clocktime3);
+    *l_computetime += (clocktime3-clocktime2);
+    /* The maximum of all processes is combined when they proceed on the event */
+    computestep = clocktime3-clocktime2;
+    iAutoSyncReduce(&maxcomputestep, &computestep, sizeof(computestep), AUTO_SYNC_MAX, xNoSpecialIntention);
+  }
+
   iAutoSyncProceedOnEvent(xTwiddleDone, P);  
 
   if ((MyNum == 0) || (dostats)) {
     CLOCK(clocktime1);
-    printf("Step 2: %8lu\n", clocktime1-clocktime2);
+    *l_waittime += (clocktime1-clocktime3);
+    printf("Step 2: %8lu (TwiddleDone wait: %8lu)\n", clocktime1-clocktime2, clocktime1-clocktime3);
   }
   /* transpose */
   Transpose(n1, scratch, x, MyNum, MyFirst, MyLast, pad_length);
@@ -849,11 +905,20 @@ void FFT1D(long direction, long M, long N, double *x, double *scratch, double *u
       Scale(n1, N, &x[2*j*(n1+pad_length)]);
   }
 
+  if ((MyNum == 0) || (dostats)) {
+    CLOCK(clocktime3);
+    *l_computetime += (clocktime3-clocktime2);
+    /* The maximum of all processes is combined when they proceed on the event */
+    computestep = clocktime3-clocktime2;
+    iAutoSyncReduce(&maxcomputestep, &computestep, sizeof(computestep), AUTO_SYNC_MAX, xNoSpecialIntention);
+  }
+
   iAutoSyncProceedOnEvent(xTwiddleDone, P); /* xFFT1Done */  
 
   if ((MyNum == 0) || (dostats)) {
     CLOCK(clocktime1);
-    printf("Step 4: %8lu\n", clocktime1-clocktime2);
+    *l_waittime += (clocktime1-clocktime3);
+    printf("Step 4: %8lu (FFT1DDone wait: %8lu)\n", clocktime1-clocktime2, clocktime1-clocktime3);
   }
 
   /* transpose back */
@@ -870,14 +935,30 @@ void FFT1D(long direction, long M, long N, double *x, double *scratch, double *u
   if ((test_result) || (doprint)) 
   {
     /* BARRIER(Global->start, P); */
+    if ((MyNum == 0) || (dostats)) {
+      CLOCK(clocktime1);
+    }
     iAutoSyncProceedOnEvent(xTwiddleDone, P);  /* xTrasnposeDone */
+    if ((MyNum == 0) || (dostats)) {
+      CLOCK(clocktime3);
+      *l_waittime += (clocktime3-clocktime1);
+      printf("TransposeDone wait: %8lu\n", clocktime3-clocktime1);
+    }
 
     for (j=MyFirst; j<MyLast; j++) {
       CopyColumn(n1, &scratch[2*j*(n1+pad_length)], &x[2*j*(n1+pad_length)]);
     }
   }
   /* BARRIER(Global->start, P); */
+  if ((MyNum == 0) || (dostats)) {
+    CLOCK(clocktime1);
+  }
   iAutoSyncProceedOnEvent(xTwiddleDone, P); /* xFFTDone */
+  if ((MyNum == 0) || (dostats)) {
+    CLOCK(clocktime3);
+    *l_waittime += (clocktime3-clocktime1);
+    printf("FFTDone wait: %8lu\n", clocktime3-clocktime1);
+  }
 }
 
 
@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define VARIANT "atomic"
+#define ARRAY_SIZE 600
+#define NO_OF_THREADS 4
+#define DENSITY 10 /* Percentage of the elements that match the pattern */
+#define PATTERN 3
+
+/**************************** Thread's prototypes *****************************/
+void* SearchThread(void* args);
+
+typedef struct xSearchSliceStruct
+{
+  uint32_t uiStart;
+  uint32_t uiEnd;
+} xSearchSlice;
+
+/****************************** Shared Variables ******************************/
+atomic_uint uiCountOccurrences = 0;
+uint32_t* puiSearchArray;
+
+uint32_t uiFillArray(uint32_t* puiArray, size_t xSize, uint32_t uiDensity);
+
+/************************************* MAIN ***********************************/
+int main(int argc, char* argv[])
+{
+  int16_t iRetVal;
+  double ElapsedTime;
+  uint32_t uiArraySize = ARRAY_SIZE;
+  uint32_t uiNoOfThreads = NO_OF_THREADS;
+  uint32_t uiDensity = DENSITY;
+  uint32_t uiExpected;
+  bool bCsv = false;
+  int iOpt;
+
+  while ((iOpt = getopt(argc, argv, "n:t:d:c")) != -1)
+  {
+    if (iOpt == 'n') uiArraySize = strtoul(optarg, NULL, 10);
+    else if (iOpt == 't') uiNoOfThreads = strtoul(optarg, NULL, 10);
+    else if (iOpt == 'd') uiDensity = strtoul(optarg, NULL, 10);
+    else if (iOpt == 'c') bCsv = true;
+    else
+    {
+      printf("Usage: %s [-n array size] [-t threads] [-d density in %%] [-c]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (uiNoOfThreads == 0 || uiDensity > 100)
+  {
+    printf("At least one thread is needed and the density is a percentage!\n");
+    return 1;
+  }
+
+  pthread_t* xThreadHandle = malloc(uiNoOfThreads * sizeof(pthread_t));
+  xSearchSlice* xSlices = malloc(uiNoOfThreads * sizeof(xSearchSlice));
+  puiSearchArray = malloc(uiArraySize * sizeof(uint32_t));
+
+  /* Initialize the random number generator */
+  srand(time(0));
+
+  uiExpected = uiFillArray(puiSearchArray, uiArraySize, uiDensity);
+
+
+  if (!bCsv)
+  {
+    printf("We must have exactly %u occurrences!\n", uiExpected);
+    printf("Starting search threads...\n\n");
+  }
+
+  /* To calculate the execution time, the wall-clock time of the search */
+  struct timespec xStart, xEnd;
+  clock_gettime(CLOCK_MONOTONIC, &xStart);
+
+  /* Create POSIX threads */
+  for (uint32_t i = 0; i < uiNoOfThreads; i++)
+  {
+    xSlices[i].uiStart = (uint64_t)i * uiArraySize / uiNoOfThreads;
+    xSlices[i].uiEnd = (uint64_t)(i + 1) * uiArraySize / uiNoOfThreads;
+
+    iRetVal = pthread_create(&xThreadHandle[i],
+                             NULL,
+                             &SearchThread,
+                             &xSlices[i]);
+  }
+
+  /* Wait Search threads finished */
+  for (uint32_t i = 0; i < uiNoOfThreads; i++)
+  {
+    iRetVal = pthread_join(xThreadHandle[i], NULL);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &xEnd);
+  ElapsedTime = (xEnd.tv_sec - xStart.tv_sec) + (xEnd.tv_nsec - xStart.tv_nsec) / 1e9; // in seconds
+
+
+  if (bCsv)
+  {
+    printf("%s,%u,%u,%u,%.9f,%s\n", VARIANT, uiNoOfThreads, uiArraySize, uiDensity, ElapsedTime,
+           uiCountOccurrences == uiExpected ? "ok" : "wrong");
+  }
+  else
+  {
+    printf("Total No Of Occurrences: %u\n", uiCountOccurrences);
+    printf("\n >>>>> Execution Time: %f seconds \n", ElapsedTime);
+  }
+
+  free(puiSearchArray);
+  free(xSlices);
+  free(xThreadHandle);
+  return uiCountOccurrences == uiExpected ? 0 : 1;
+}
+
+uint32_t uiFillArray(uint32_t* puiArray, size_t xSize, uint32_t uiDensity)
+{
+    uint32_t uiHits = 0;
+
+    /* Generate random number between 5 and 10                           */
+    /* For the first uiDensity indexes of every 100, insert pattern      */
+    /* That way we have a deterministic number of occurrences            */
+    for (uint32_t i = 0; i < xSize; i++)
+    {
+        puiArray[i] = (rand() % (6)) + 5;
+
+        if (i % 100 < uiDensity)
+        {
+            puiArray[i] = PATTERN;
+            uiHits++;
+        }
+    }
+    return uiHits;
+}
+
+/****************************** Thread's Bodies *******************************/
+void* SearchThread(void* args)
+{
+    xSearchSlice* pxSlice = (xSearchSlice*)args;
+
+    for (uint32_t i = pxSlice->uiStart; i < pxSlice->uiEnd; i++)
+    {
+        if(puiSearchArray[i] == PATTERN)
+        {
+            atomic_fetch_add_explicit(&uiCountOccurrences, 1, memory_order_relaxed);
+        }
+    }
+    return NULL;
+}
@@ -4,9 +4,13 @@
 #include <string.h>
 #include <unistd.h>
 #include <time.h>
+#include <stdbool.h>
+#include <stdint.h>
 
+#define VARIANT "posix"
 #define ARRAY_SIZE 600
 #define NO_OF_THREADS 4
+#define DENSITY 10 /* Percentage of the elements that match the pattern */
 #define PATTERN 3
 
 pthread_mutex_t mutex;
@@ -14,92 +18,142 @@ pthread_mutex_t mutex;
 /**************************** Thread's prototypes *****************************/
 void* SearchThread(void* args);
 
+typedef struct xSearchSliceStruct
+{
+  uint32_t uiStart;
+  uint32_t uiEnd;
+} xSearchSlice;
+
 /****************************** Shared Variables ******************************/
 uint32_t uiCountOccurrences = 0;
-uint32_t uiSearchArray[ARRAY_SIZE];
+uint32_t* puiSearchArray;
 
-void vFillArray(uint32_t* puiArray, size_t xSize);
+uint32_t uiFillArray(uint32_t* puiArray, size_t xSize, uint32_t uiDensity);
 
 /************************************* MAIN ***********************************/
-int main(int argc, char const *argv[])
-{  
+int main(int argc, char* argv[])
+{
   int16_t iRetVal;
   double ElapsedTime;
-  pthread_t xThreadHandle[NO_OF_THREADS]; 
+  uint32_t uiArraySize = ARRAY_SIZE;
+  uint32_t uiNoOfThreads = NO_OF_THREADS;
+  uint32_t uiDensity = DENSITY;
+  uint32_t uiExpected;
+  bool bCsv = false;
+  int iOpt;
+
+  while ((iOpt = getopt(argc, argv, "n:t:d:c")) != -1)
+  {
+    if (iOpt == 'n') uiArraySize = strtoul(optarg, NULL, 10);
+    else if (iOpt == 't') uiNoOfThreads = strtoul(optarg, NULL, 10);
+    else if (iOpt == 'd') uiDensity = strtoul(optarg, NULL, 10);
+    else if (iOpt == 'c') bCsv = true;
+    else
+    {
+      printf("Usage: %s [-n array size] [-t threads] [-d density in %%] [-c]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (uiNoOfThreads == 0 || uiDensity > 100)
+  {
+    printf("At least one thread is needed and the density is a percentage!\n");
+    return 1;
+  }
+
+  pthread_t* xThreadHandle = malloc(uiNoOfThreads * sizeof(pthread_t));
+  xSearchSlice* xSlices = malloc(uiNoOfThreads * sizeof(xSearchSlice));
+  puiSearchArray = malloc(uiArraySize * sizeof(uint32_t));
 
   /* Initialize the random number generator */
   srand(time(0));
 
-  vFillArray(uiSearchArray, sizeof(uiSearchArray)/sizeof(uint32_t));
-  
-  /* To calculate the execution time */
-  clock_t t;
-  t = clock();
+  uiExpected = uiFillArray(puiSearchArray, uiArraySize, uiDensity);
 
   pthread_mutex_init(&mutex, NULL);
-  
-  printf("We must have exactly %d occurrences!\n", ARRAY_SIZE/10);
-  
-  printf("Starting search threads...\n\n");
+
+  if (!bCsv)
+  {
+    printf("We must have exactly %u occurrences!\n", uiExpected);
+    printf("Starting search threads...\n\n");
+  }
+
+  /* To calculate the execution time, the wall-clock time of the search */
+  struct timespec xStart, xEnd;
+  clock_gettime(CLOCK_MONOTONIC, &xStart);
+
   /* Create POSIX threads */
-  for (uint8_t i = 0; i < NO_OF_THREADS; i++)
+  for (uint32_t i = 0; i < uiNoOfThreads; i++)
   {
-    uint8_t* a = malloc(sizeof(uint8_t));
-    *a = i;
+    xSlices[i].uiStart = (uint64_t)i * uiArraySize / uiNoOfThreads;
+    xSlices[i].uiEnd = (uint64_t)(i + 1) * uiArraySize / uiNoOfThreads;
 
     iRetVal = pthread_create(&xThreadHandle[i],
                              NULL,
                              &SearchThread,
-                             a);
+                             &xSlices[i]);
   }
-    
+
   /* Wait Search threads finished */
-  for (uint8_t i = 0; i < NO_OF_THREADS; i++)
+  for (uint32_t i = 0; i < uiNoOfThreads; i++)
   {
-    iRetVal = pthread_join(xThreadHandle[i], NULL);   
+    iRetVal = pthread_join(xThreadHandle[i], NULL);
   }
 
-  pthread_mutex_destroy(&mutex);
+  clock_gettime(CLOCK_MONOTONIC, &xEnd);
+  ElapsedTime = (xEnd.tv_sec - xStart.tv_sec) + (xEnd.tv_nsec - xStart.tv_nsec) / 1e9; // in seconds
 
-  printf("Total No Of Occurrences: %d\n", uiCountOccurrences);
+  pthread_mutex_destroy(&mutex);
 
-  t = clock() - t;
-  ElapsedTime = ((double)t)/CLOCKS_PER_SEC; // in seconds
-  printf("\n >>>>> Execution Time: %f seconds \n", ElapsedTime);
+  if (bCsv)
+  {
+    printf("%s,%u,%u,%u,%.9f,%s\n", VARIANT, uiNoOfThreads, uiArraySize, uiDensity, ElapsedTime,
+           uiCountOccurrences == uiExpected ? "ok" : "wrong");
+  }
+  else
+  {
+    printf("Total No Of Occurrences: %u\n", uiCountOccurrences);
+    printf("\n >>>>> Execution Time: %f seconds \n", ElapsedTime);
+  }
 
-  return 0;
+  free(puiSearchArray);
+  free(xSlices);
+  free(xThreadHandle);
+  return uiCountOccurrences == uiExpected ? 0 : 1;
 }
 
-void vFillArray(uint32_t* puiArray, size_t xSize)
-{    
-    uint8_t num;
-    
-    /* Generate random number between 5 and 10                */
-    /* For the indexes multiple of 10, insert pattern         */
-    /* That way we have a deterministic number of occurrences */
+uint32_t uiFillArray(uint32_t* puiArray, size_t xSize, uint32_t uiDensity)
+{
+    uint32_t uiHits = 0;
+
+    /* Generate random number between 5 and 10                           */
+    /* For the first uiDensity indexes of every 100, insert pattern      */
+    /* That way we have a deterministic number of occurrences            */
     for (uint32_t i = 0; i < xSize; i++)
     {
         puiArray[i] = (rand() % (6)) + 5;
 
-        if (i % 10 == 0)puiArray[i] = PATTERN;
-    }   
+        if (i % 100 < uiDensity)
+        {
+            puiArray[i] = PATTERN;
+            uiHits++;
+        }
+    }
+    return uiHits;
 }
 
 /****************************** Thread's Bodies *******************************/
 void* SearchThread(void* args)
 {
-    uint32_t uiIndex = *(uint8_t*)args;
-    uint32_t uiStart = uiIndex * (ARRAY_SIZE/NO_OF_THREADS);
-    uint32_t uiEnd = uiStart + ARRAY_SIZE/NO_OF_THREADS -1;
-   
-    for (uint32_t i = uiStart; i < uiEnd; i++)
+    xSearchSlice* pxSlice = (xSearchSlice*)args;
+
+    for (uint32_t i = pxSlice->uiStart; i < pxSlice->uiEnd; i++)
     {
-        if(uiSearchArray[i] == PATTERN)
-        {            
+        if(puiSearchArray[i] == PATTERN)
+        {
             pthread_mutex_lock(&mutex);
             uiCountOccurrences++;
             pthread_mutex_unlock(&mutex);
-        }        
-    } 
+        }
+    }
+    return NULL;
 }
-
@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../../src/AutoSync.h"
+
+#define NO_OF_ITEMS 100000
+#define NO_OF_WORKERS 3
+#define RAW_QUEUE_SIZE 64
+#define WORK_QUEUE_SIZE 256
+
+/**************************** Thread's prototypes *****************************/
+void* ProducerThread(void* args);
+void* FilterThread(void* args);
+void* WorkerThread(void* args);
+
+typedef struct xPipelineItemStruct
+{
+  uint64_t uiValue;
+  bool bLast; /* No item follows, the thread that dequeues it stops */
+} xPipelineItem;
+
+/****************************** Shared Variables ******************************/
+/* The producer hands the items to the filter, the filter hands them to the workers */
+xPipelineItem xRawQueue[RAW_QUEUE_SIZE];
+xPipelineItem xWorkQueue[WORK_QUEUE_SIZE];
+uint64_t uiSum = 0;
+
+/****************************** AutoSync Intentions ***************************/
+xAutoSyncIntentions xIntentionRawQueue = {.uiQueueCapacity = RAW_QUEUE_SIZE};
+xAutoSyncIntentions xIntentionWorkQueue = {.uiQueueCapacity = WORK_QUEUE_SIZE};
+xAutoSyncIntentions xNoSpecialIntention;
+
+/************************************* MAIN ***********************************/
+int main(int argc, char* argv[])
+{
+  pthread_t xProducerHandle;
+  pthread_t xFilterHandle;
+  pthread_t xWorkerHandle[NO_OF_WORKERS];
+  uint64_t uiExpected = 0;
+  double ElapsedTime;
+
+  /* Only the odd values pass the filter, the workers add up their squares */
+  for (uint64_t i = 1; i <= NO_OF_ITEMS; i += 2)
+  {
+    uiExpected += i * i;
+  }
+
+  iAutoSyncCreate();
+
+  /* To calculate the execution time, the wall-clock time of the pipeline */
+  struct timespec xStart, xEnd;
+  clock_gettime(CLOCK_MONOTONIC, &xStart);
+
+  pthread_create(&xProducerHandle, NULL, &ProducerThread, NULL);
+  pthread_create(&xFilterHandle, NULL, &FilterThread, NULL);
+  for (uint32_t i = 0; i < NO_OF_WORKERS; i++)
+  {
+    pthread_create(&xWorkerHandle[i], NULL, &WorkerThread, NULL);
+  }
+
+  pthread_join(xProducerHandle, NULL);
+  pthread_join(xFilterHandle, NULL);
+  for (uint32_t i = 0; i < NO_OF_WORKERS; i++)
+  {
+    pthread_join(xWorkerHandle[i], NULL);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &xEnd);
+  ElapsedTime = (xEnd.tv_sec - xStart.tv_sec) + (xEnd.tv_nsec - xStart.tv_nsec) / 1e9; // in seconds
+
+  iAutoSyncDestroy();
+
+  printf("Sum of the squares: %lu (%s)\n", (unsigned long)uiSum, uiSum == uiExpected ? "ok" : "wrong");
+  printf("\n >>>>> Execution Time: %f seconds \n", ElapsedTime);
+  return uiSum == uiExpected ? 0 : 1;
+}
+
+/****************************** Thread's Bodies *******************************/
+void* ProducerThread(void* args)
+{
+  xPipelineItem xItem = {.bLast = false};
+
+  for (uint64_t i = 1; i <= NO_OF_ITEMS; i++)
+  {
+    xItem.uiValue = i;
+    iAutoSyncEnqueue(xRawQueue, &xItem, sizeof(xItem), xIntentionRawQueue);
+  }
+  xItem.bLast = true;
+  iAutoSyncEnqueue(xRawQueue, &xItem, sizeof(xItem), xIntentionRawQueue);
+  return NULL;
+}
+
+void* FilterThread(void* args)
+{
+  xPipelineItem xItem;
+
+  do
+  {
+    iAutoSyncDequeue(&xItem, xRawQueue, sizeof(xItem), xIntentionRawQueue);
+    if (!xItem.bLast && xItem.uiValue % 2 == 1)
+    {
+      iAutoSyncEnqueue(xWorkQueue, &xItem, sizeof(xItem), xIntentionWorkQueue);
+    }
+  } while (!xItem.bLast);
+
+  /* Every worker stops at its own last item */
+  for (uint32_t i = 0; i < NO_OF_WORKERS; i++)
+  {
+    iAutoSyncEnqueue(xWorkQueue, &xItem, sizeof(xItem), xIntentionWorkQueue);
+  }
+  return NULL;
+}
+
+void* WorkerThread(void* args)
+{
+  xPipelineItem xItem;
+  uint64_t uiLocalSum = 0;
+  uint64_t uiSumLocal;
+
+  for (;;)
+  {
+    iAutoSyncDequeue(&xItem, xWorkQueue, sizeof(xItem), xIntentionWorkQueue);
+    if (xItem.bLast)
+    {
+      break;
+    }
+    uiLocalSum += xItem.uiValue * xItem.uiValue;
+  }
+
+  iAutoSyncReadToUpdate(&uiSumLocal, &uiSum, sizeof(uiSumLocal), xNoSpecialIntention);
+  uiSumLocal += uiLocalSum;
+  iAutoSyncUpdate(&uiSum, &uiSumLocal, sizeof(uiSumLocal), xNoSpecialIntention);
+  return NULL;
+}
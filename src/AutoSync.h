@@ -16,6 +16,10 @@
 
 /* Definition of constants */
 #define MAX_DEPENDENCIES 10 /* Increase it if more is needed */
+#define AUTO_SYNC_MAX_THREADS 256 /* Maximum number of threads with a private reduction slot */
+#define AUTO_SYNC_MAX_ROUNDS 8 /* log2(AUTO_SYNC_MAX_THREADS), rounds of the dissemination barrier */
+#define AUTO_SYNC_CACHE_LINE_SIZE 64
+#define AUTO_SYNC_SPIN_COUNT 1000 /* Iterations a thread spins before it sleeps or yields */
 
 /* EXTERNAL VARIABLES */
 
@@ -24,13 +28,37 @@ typedef struct xAutoSyncIntentionsStruct
 {  
   void* pvDependsOn[MAX_DEPENDENCIES];  
   bool bConstantInitByMain;  
+  bool bOptimisticRead; /* Small read-mostly shared-variable, read without lock and retried if a write overlapped */
+  bool bDeferredUpdate; /* Updates in a loop may become visible later, at the latest when the loop ends */
   bool bSlicedArray;
   uint64_t uiFirstAccess;
   uint64_t uiLastAccess;  
+  uint32_t uiQueueCapacity; /* Items a queue holds, a power of two. The array of the queue is used if it is not given */
+  bool bSingleProducer; /* Only one thread enqueues, if the parser cannot count the threads */
+  bool bSingleConsumer; /* Only one thread dequeues, if the parser cannot count the threads */
 } const xAutoSyncIntentions;  
 
 typedef int8_t xAutoSyncEvent;
 
+/* Barrier algorithms, selected when declaring an event (e.g. xAutoSyncEvent xDone = AUTO_SYNC_BARRIER_TREE;) */
+typedef enum eAutoSyncBarrier
+{
+  AUTO_SYNC_BARRIER_DEFAULT,          /* Mutex and condition variable */
+  AUTO_SYNC_BARRIER_SENSE_REVERSING,  /* Centralized sense-reversing counter, spin then futex */
+  AUTO_SYNC_BARRIER_DISSEMINATION,    /* log(P) rounds of pairwise signals, no shared counter */
+  AUTO_SYNC_BARRIER_TREE              /* Combining tree of counters, spin then futex on release */
+} xAutoSyncBarrier;
+
+/* Operations supported by iAutoSyncReduce */
+typedef enum eAutoSyncReduceOp
+{
+  AUTO_SYNC_SUM,
+  AUTO_SYNC_MIN,
+  AUTO_SYNC_MAX,
+  AUTO_SYNC_AND,
+  AUTO_SYNC_OR
+} xAutoSyncReduceOp;
+
 
 /*******************************************************************************
 *                              INTERFACE DEFINTION
@@ -43,6 +71,15 @@ int8_t iAutoSyncWrite(void* pvSharedVar, void* pvValue, size_t xSizeData, xAutoS
 int8_t iAutoSyncReadToUpdate(void* pvValue, void* pvSharedVar, size_t xSizeData, xAutoSyncIntentions xIntention);
 int8_t iAutoSyncUpdate(void* pvSharedVar, void* pvValue, size_t xSizeData, xAutoSyncIntentions xIntention);
 
+/* Combine pvValue into pvSharedVar. The result is only visible after the next iAutoSyncProceedOnEvent or after the 
+   reducing thread has finished */
+int8_t iAutoSyncReduce(void* pvSharedVar, void* pvValue, size_t xSizeData, xAutoSyncReduceOp xOp, xAutoSyncIntentions xIntention);
+
+/* Hand items between threads through a queue, pvQueue is the array that holds the items (e.g. xWorkItem xQueue[16]).
+   iAutoSyncEnqueue waits while the queue is full, iAutoSyncDequeue waits while it is empty */
+int8_t iAutoSyncEnqueue(void* pvQueue, void* pvItem, size_t xSizeData, xAutoSyncIntentions xIntention);
+int8_t iAutoSyncDequeue(void* pvItem, void* pvQueue, size_t xSizeData, xAutoSyncIntentions xIntention);
+
 int8_t iAutoSyncSharedVarAsArg(void* pvSharedVar);
 
 int8_t iAutoSyncProceedOnEvent(xAutoSyncEvent xEvent, uint8_t uiNoOfThreads); 
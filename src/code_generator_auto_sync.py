@@ -1,9 +1,12 @@
 from __future__ import print_function
-from collections import Iterable
+from collections.abc import Iterable
 import sys
+import argparse
 import json
 import copy
 import re
+import os
+import contextlib
 import pprint
 
 AUTO_SYNC_VALUE_ARG = "pvValue"
@@ -14,12 +17,76 @@ AUTO_SYNC_WRITE = "iAutoSyncWrite"
 AUTO_SYNC_READ_TO_UPDATE = "iAutoSyncReadToUpdate"
 AUTO_SYNC_UPDATE = "iAutoSyncUpdate"
 AUTO_SYNC_PROCEED_ON_EVENT = "iAutoSyncProceedOnEvent"
+AUTO_SYNC_REDUCE = "iAutoSyncReduce"
+AUTO_SYNC_ENQUEUE = "iAutoSyncEnqueue"
+AUTO_SYNC_DEQUEUE = "iAutoSyncDequeue"
+AUTO_SYNC_BARRIER_DEFAULT = "AUTO_SYNC_BARRIER_DEFAULT"
+AUTO_SYNC_BARRIER_SENSE_REVERSING = "AUTO_SYNC_BARRIER_SENSE_REVERSING"
+AUTO_SYNC_BARRIER_DISSEMINATION = "AUTO_SYNC_BARRIER_DISSEMINATION"
+AUTO_SYNC_BARRIER_TREE = "AUTO_SYNC_BARRIER_TREE"
+# Not selectable in AutoSync.h, the OpenMP backend lowers the events of the whole parallel region to #pragma omp barrier
+AUTO_SYNC_BARRIER_OMP = "AUTO_SYNC_BARRIER_OMP"
+# Calls of the interface that the parser records and the code generator replaces
+AUTO_SYNC_SITES = [AUTO_SYNC_READ, AUTO_SYNC_WRITE, AUTO_SYNC_READ_TO_UPDATE, AUTO_SYNC_UPDATE, AUTO_SYNC_REDUCE, AUTO_SYNC_ENQUEUE,
+                   AUTO_SYNC_DEQUEUE, AUTO_SYNC_PROCEED_ON_EVENT]
 AUTO_SYNC_RET_VAL = "int8_t"
+FUNC_CREATE_TASK = "pthread_create"
+FUNC_JOIN_TASK = "pthread_join"
 AUTO_SYNC_GENERATED = "/* Generated by AutoSync */\n"
 
 
 MUTEX_LOCK = "pthread_mutex_lock"
 MUTEX_UNLOCK = "pthread_mutex_unlock"
+# Libraries the generated locks are taken from
+BACKEND_PTHREAD = "pthread"
+BACKEND_C11 = "c11"
+BACKEND_FUTEX = "futex"
+BACKEND_OPENMP = "openmp"
+# Maximum quantity of mutexes that protect the slices of an array (lock striping)
+LOCK_STRIPES = 64
+# Minimum share of read accesses for replacing a mutex by a reader-writer lock
+READ_SHARE_RWLOCK = 0.8
+# Locks with fewer contended acquisitions in a lock profile keep their mutex, the shorter held ones become spin locks
+PROFILE_CONTENDED_SHARE = 0.01
+PROFILE_SPIN_HOLD_NS = 1000
+# Instances assumed for a thread whose quantity is only known at runtime (e.g. "P"), a loop creates more than one
+RUNTIME_NO_OF_THREADS = 2
+# Updates of a shared-variable with the intention bDeferredUpdate that are combined in a loop before they are applied
+BATCH_SIZE = 64
+RWLOCK = "pthread_rwlock_t"
+SPIN_RWLOCK = "xAutoSyncSpinRWLock"
+# Ring buffers of the queues: one producer and one consumer, or any quantity of both (Vyukov)
+QUEUE_SPSC = "SPSC"
+QUEUE_MPMC = "MPMC"
+# Attribute used to initialize every type of mutex
+MUTEX_RECURSIVE = "PTHREAD_MUTEX_RECURSIVE"
+MUTEX_NORMAL = "PTHREAD_MUTEX_NORMAL"
+MUTEX_ADAPTIVE = "PTHREAD_MUTEX_ADAPTIVE_NP"
+MUTEX_ATTRS = {MUTEX_RECURSIVE: "xMutexAttr", MUTEX_NORMAL: "xMutexAttrNormal", MUTEX_ADAPTIVE: "xMutexAttrAdaptive"}
+# Layout of the generated locks: declared back-to-back, aligned to a cache line each, 
+# or aligned and in the same struct as the only shared-variable that they protect
+LAYOUT_PACKED = "packed"
+LAYOUT_ALIGNED = "aligned"
+LAYOUT_COLOCATED = "colocated"
+
+# Types that are lowered to C11 atomics when they are updated with a simple arithmetic operation
+# All of them are naturally aligned and have at most 8 bytes in the supported ABIs
+ATOMIC_INTEGER_TYPES = ["char", "short", "int", "long", "signed", "unsigned", "_Bool", "bool", "size_t",
+                        "int8_t", "int16_t", "int32_t", "int64_t", "uint8_t", "uint16_t", "uint32_t", "uint64_t",
+                        "intptr_t", "uintptr_t"]
+# atomic_fetch_* is not defined for atomic bool, its updates are CAS loops
+ATOMIC_FETCH_TYPES = [word for word in ATOMIC_INTEGER_TYPES if word not in ["_Bool", "bool"]]
+# Types that are known before the user's declarations, so they can be used in the generated header
+BASIC_TYPES = ATOMIC_INTEGER_TYPES + ["float", "double"]
+# C expression of every reduction operation, combining the values a and b
+REDUCE_OPS = {"AUTO_SYNC_SUM": "{a} + {b}",
+              "AUTO_SYNC_MIN": "({b} < {a}) ? {b} : {a}",
+              "AUTO_SYNC_MAX": "({b} > {a}) ? {b} : {a}",
+              "AUTO_SYNC_AND": "{a} & {b}",
+              "AUTO_SYNC_OR": "{a} | {b}"}
+ATOMIC_FETCH_OPS = {"+=": "atomic_fetch_add_explicit", "-=": "atomic_fetch_sub_explicit",
+                    "|=": "atomic_fetch_or_explicit", "&=": "atomic_fetch_and_explicit",
+                    "^=": "atomic_fetch_xor_explicit"}
 
 # This is not required if you've installed pycparser into your site-packages/ with setup.py
 sys.path.extend(['.', '..'])
@@ -70,6 +137,376 @@ def flatten(lis: list) -> list:
              yield item
 
 
+def get_call_args(line: str, func_sig: str) -> list:
+    '''
+    Get the arguments of an AutoSync call as they are written in the source line.
+    Returns an empty list if the call is not (completely) in the line.
+    '''
+    match = re.search(r"\b" + func_sig + r"\s*\(", line)
+    if match is None:
+        return []
+
+    args = []
+    depth = 0
+    arg = ""
+    for char in line[match.end():]:
+        if char in "([":
+            depth += 1
+        elif char in ")]":
+            if depth == 0:
+                args.append(arg.strip())
+                return args
+            depth -= 1
+        elif char == "," and depth == 0:
+            args.append(arg.strip())
+            arg = ""
+            continue
+        arg += char
+
+    return []
+
+
+def c_identifier(shared_var: str) -> str:
+    '''
+    Get a valid C identifier for a shared-variable (e.g. "Global->id" -> "Global_id")
+    '''
+    return shared_var.replace(".", "_").replace("->", "_")
+
+
+def deref_arg(arg: str) -> str:
+    '''
+    Get the lvalue pointed by an argument of the interface (e.g. "&uiCount" -> "uiCount")
+    '''
+    if arg.startswith("&"):
+        return arg[1:].strip()
+    return f"*({arg})"
+
+
+# The C text of the locks, condition variables and their initialization for every backend. The locks are passed as
+# the C expression of their address (e.g. "&xMutex_N")
+class PthreadBackend():
+    mutex_type = "pthread_mutex_t"
+    cond_type = "pthread_cond_t"
+    # pthread_rwlock_t is only available with pthreads, the other backends keep the mutex
+    rwlocks = True
+    # Barrier of the events that do not select one
+    default_barrier = AUTO_SYNC_BARRIER_DEFAULT
+    # The threads run in an OpenMP parallel region, the critical sections and events can be lowered to pragmas
+    openmp = False
+    # Mutexes whose critical sections are named OpenMP critical regions instead of locks
+    critical_mutexes = frozenset()
+
+
+    def lock(self, mutex: str) -> str:
+        return f"{MUTEX_LOCK}({mutex})"
+
+
+    def try_lock(self, mutex: str) -> str:
+        # 0 if the mutex was taken
+        return f"pthread_mutex_trylock({mutex})"
+
+
+    def unlock(self, mutex: str) -> str:
+        return f"{MUTEX_UNLOCK}({mutex})"
+
+
+    def cond_wait(self, cond_var: str, mutex: str) -> str:
+        return f"pthread_cond_wait({cond_var}, {mutex})"
+
+
+    def cond_broadcast(self, cond_var: str) -> str:
+        return f"pthread_cond_broadcast({cond_var})"
+
+
+    def decl_attrs(self) -> str:
+        return "".join(f"pthread_mutexattr_t {attr};\n" for attr in MUTEX_ATTRS.values())
+
+
+    def init_attrs(self) -> str:
+        # Init the attributes of every type of mutex, adaptive mutexes spin before sleeping (glibc only)
+        code = ""
+        for mutex_type, attr in MUTEX_ATTRS.items():
+            code += f"  pthread_mutexattr_init(&{attr});\n"
+            if mutex_type == MUTEX_ADAPTIVE:
+                code += "#ifdef __GLIBC__\n"
+                code += f"  pthread_mutexattr_settype(&{attr}, {MUTEX_ADAPTIVE});\n"
+                code += "#else\n"
+                code += f"  pthread_mutexattr_settype(&{attr}, {MUTEX_NORMAL});\n"
+                code += "#endif\n"
+            else:
+                code += f"  pthread_mutexattr_settype(&{attr}, {mutex_type});\n"
+        return code + "\n"
+
+
+    def init_mutex(self, mutex: str, mutex_type: str) -> str:
+        return f"assert(pthread_mutex_init({mutex}, &{MUTEX_ATTRS[mutex_type]}) == 0);"
+
+
+    def destroy_mutex(self, mutex: str) -> str:
+        return f"assert(pthread_mutex_destroy({mutex}) == 0);"
+
+
+    def init_cond(self, cond_var: str) -> str:
+        return f"assert(pthread_cond_init({cond_var}, NULL) == 0);"
+
+
+    def destroy_cond(self, cond_var: str) -> str:
+        return f"assert(pthread_cond_destroy({cond_var}) == 0);"
+
+
+    def create_header(self) -> str:
+        # Includes and runtime of the backend in _AutoSync.h
+        return ""
+
+
+    def create_impl(self) -> str:
+        # Runtime of the backend in _AutoSync.c
+        return ""
+
+
+# C11 <threads.h>, without reader-writer locks and adaptive mutexes
+class C11Backend(PthreadBackend):
+    mutex_type = "mtx_t"
+    cond_type = "cnd_t"
+    rwlocks = False
+
+
+    def lock(self, mutex: str) -> str:
+        return f"mtx_lock({mutex})"
+
+
+    def try_lock(self, mutex: str) -> str:
+        return f"(mtx_trylock({mutex}) != thrd_success)"
+
+
+    def unlock(self, mutex: str) -> str:
+        return f"mtx_unlock({mutex})"
+
+
+    def cond_wait(self, cond_var: str, mutex: str) -> str:
+        return f"cnd_wait({cond_var}, {mutex})"
+
+
+    def cond_broadcast(self, cond_var: str) -> str:
+        return f"cnd_broadcast({cond_var})"
+
+
+    def decl_attrs(self) -> str:
+        return ""
+
+
+    def init_attrs(self) -> str:
+        return ""
+
+
+    def init_mutex(self, mutex: str, mutex_type: str) -> str:
+        return f"assert(mtx_init({mutex}, mtx_plain{' | mtx_recursive' if mutex_type == MUTEX_RECURSIVE else ''}) == thrd_success);"
+
+
+    def destroy_mutex(self, mutex: str) -> str:
+        return f"mtx_destroy({mutex});"
+
+
+    def init_cond(self, cond_var: str) -> str:
+        return f"assert(cnd_init({cond_var}) == thrd_success);"
+
+
+    def destroy_cond(self, cond_var: str) -> str:
+        return f"cnd_destroy({cond_var});"
+
+
+    def create_header(self) -> str:
+        return "#include <threads.h>\n"
+
+
+# Mutexes of the AutoSync runtime that spin and then park on a futex. The events wait on the sense-reversing barrier,
+# which also parks on a futex, so no condition variable is needed
+class FutexBackend(C11Backend):
+    mutex_type = "xAutoSyncFutexMutex"
+    cond_type = None
+    default_barrier = AUTO_SYNC_BARRIER_SENSE_REVERSING
+
+
+    def lock(self, mutex: str) -> str:
+        return f"vAutoSyncFutexMutexLock({mutex})"
+
+
+    def try_lock(self, mutex: str) -> str:
+        return f"iAutoSyncFutexMutexTryLock({mutex})"
+
+
+    def unlock(self, mutex: str) -> str:
+        return f"vAutoSyncFutexMutexUnlock({mutex})"
+
+
+    def init_mutex(self, mutex: str, mutex_type: str) -> str:
+        return f"vAutoSyncFutexMutexInit({mutex}, {'true' if mutex_type == MUTEX_RECURSIVE else 'false'});"
+
+
+    def destroy_mutex(self, mutex: str) -> str:
+        return ""
+
+
+    def create_header(self) -> str:
+        return f"""{AUTO_SYNC_GENERATED}typedef struct xAutoSyncFutexMutexStruct
+{{
+  atomic_uint uiState; /* 0: unlocked, 1: locked, 2: locked and threads could be parked */
+  bool bRecursive;
+  uint32_t uiDepth;
+  _Atomic(const void*) pvOwner;
+}} xAutoSyncFutexMutex;
+
+/* The address of a thread local variable identifies the owner of a recursive mutex */
+extern _Thread_local char cAutoSyncFutexSelf;
+
+void vAutoSyncFutexMutexLockSlow(xAutoSyncFutexMutex* pxMutex);
+void vAutoSyncFutexMutexWake(xAutoSyncFutexMutex* pxMutex);
+
+static inline void vAutoSyncFutexMutexInit(xAutoSyncFutexMutex* pxMutex, bool bRecursive)
+{{
+  atomic_init(&pxMutex->uiState, 0);
+  pxMutex->bRecursive = bRecursive;
+  pxMutex->uiDepth = 0;
+  atomic_init(&pxMutex->pvOwner, NULL);
+}}
+
+/* Like pthread_mutex_trylock, 0 if the mutex was taken */
+static inline int iAutoSyncFutexMutexTryLock(xAutoSyncFutexMutex* pxMutex)
+{{
+  uint32_t uiExpected = 0;
+
+  if (pxMutex->bRecursive && atomic_load_explicit(&pxMutex->pvOwner, memory_order_relaxed) == &cAutoSyncFutexSelf) {{
+    pxMutex->uiDepth++;
+    return 0;
+  }}
+  if (!atomic_compare_exchange_strong_explicit(&pxMutex->uiState, &uiExpected, 1, memory_order_acquire, memory_order_relaxed)) {{
+    return 1;
+  }}
+  if (pxMutex->bRecursive) {{
+    atomic_store_explicit(&pxMutex->pvOwner, &cAutoSyncFutexSelf, memory_order_relaxed);
+    pxMutex->uiDepth = 1;
+  }}
+  return 0;
+}}
+
+static inline void vAutoSyncFutexMutexLock(xAutoSyncFutexMutex* pxMutex)
+{{
+  if (iAutoSyncFutexMutexTryLock(pxMutex) != 0) {{
+    vAutoSyncFutexMutexLockSlow(pxMutex);
+  }}
+}}
+
+static inline void vAutoSyncFutexMutexUnlock(xAutoSyncFutexMutex* pxMutex)
+{{
+  if (pxMutex->bRecursive) {{
+    if (--pxMutex->uiDepth > 0) {{
+      return;
+    }}
+    atomic_store_explicit(&pxMutex->pvOwner, NULL, memory_order_relaxed);
+  }}
+  if (atomic_exchange_explicit(&pxMutex->uiState, 0, memory_order_release) == 2) {{
+    vAutoSyncFutexMutexWake(pxMutex);
+  }}
+}}
+
+"""
+
+
+    def create_impl(self) -> str:
+        return f"""
+{AUTO_SYNC_GENERATED}_Thread_local char cAutoSyncFutexSelf;
+
+void vAutoSyncFutexMutexLockSlow(xAutoSyncFutexMutex* pxMutex)
+{{
+  uint32_t uiSpin;
+  uint32_t uiExpected;
+  bool bLocked = false;
+
+  /* The critical sections are short, the owner probably unlocks the mutex while this thread spins */
+  for (uiSpin = 0; uiSpin < AUTO_SYNC_SPIN_COUNT && !bLocked; uiSpin++) {{
+    uiExpected = 0;
+    bLocked = atomic_load_explicit(&pxMutex->uiState, memory_order_relaxed) == 0 &&
+              atomic_compare_exchange_weak_explicit(&pxMutex->uiState, &uiExpected, 1, memory_order_acquire, memory_order_relaxed);
+  }}
+
+  /* Park, the state 2 makes the owner wake a parked thread when it unlocks the mutex */
+  while (!bLocked && atomic_exchange_explicit(&pxMutex->uiState, 2, memory_order_acquire) != 0) {{
+#ifdef __linux__
+    syscall(SYS_futex, &pxMutex->uiState, FUTEX_WAIT_PRIVATE, 2, NULL, NULL, 0);
+#else
+    sched_yield();
+#endif
+  }}
+
+  if (pxMutex->bRecursive) {{
+    atomic_store_explicit(&pxMutex->pvOwner, &cAutoSyncFutexSelf, memory_order_relaxed);
+    pxMutex->uiDepth = 1;
+  }}
+}}
+
+void vAutoSyncFutexMutexWake(xAutoSyncFutexMutex* pxMutex)
+{{
+#ifdef __linux__
+  syscall(SYS_futex, &pxMutex->uiState, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#endif
+}}
+"""
+
+
+# OpenMP locks, the threads of main are a parallel region (see assign_parallel_region)
+class OpenMPBackend(PthreadBackend):
+    # Nestable, so every mutex has the same type whether it is recursive or not
+    mutex_type = "omp_nest_lock_t"
+    cond_type = None
+    rwlocks = False
+    default_barrier = AUTO_SYNC_BARRIER_SENSE_REVERSING
+    openmp = True
+
+
+    def lock(self, mutex: str) -> str:
+        return f"omp_set_nest_lock({mutex})"
+
+
+    def try_lock(self, mutex: str) -> str:
+        return f"(omp_test_nest_lock({mutex}) == 0)"
+
+
+    def unlock(self, mutex: str) -> str:
+        return f"omp_unset_nest_lock({mutex})"
+
+
+    def decl_attrs(self) -> str:
+        return ""
+
+
+    def init_attrs(self) -> str:
+        return ""
+
+
+    def init_mutex(self, mutex: str, mutex_type: str) -> str:
+        return f"omp_init_nest_lock({mutex});"
+
+
+    def destroy_mutex(self, mutex: str) -> str:
+        return f"omp_destroy_nest_lock({mutex});"
+
+
+    def create_header(self) -> str:
+        return f"""{AUTO_SYNC_GENERATED}#include <omp.h>
+
+/* Arguments of the threads created by main, the thread with the same number in the parallel region gets them */
+void* pvAutoSyncOmpArgs[AUTO_SYNC_MAX_THREADS];
+uint32_t uiAutoSyncOmpThreads;
+
+"""
+
+
+SYNC_BACKENDS = {BACKEND_PTHREAD: PthreadBackend(), BACKEND_C11: C11Backend(), BACKEND_FUTEX: FutexBackend(),
+                 BACKEND_OPENMP: OpenMPBackend()}
+# Selected with --backend
+sync_backend = SYNC_BACKENDS[BACKEND_PTHREAD]
+
+
 def create_shared_var_array(shared_vars: list, ast_arg: c_ast.FileAST) -> c_ast.FileAST:
     SHARED_VAR_ARRAY_NAME = "pvSharedVarArray"
     for node in ast_arg.ext:
@@ -102,20 +539,50 @@ def create_shared_var_enum(shared_vars: list, ast_arg: c_ast.FileAST) -> c_ast.F
     return ast_arg
 
 
-def decl_mutexes(mutexes: dict, events_mutexes: list) -> str:
+def decl_mutexes(mutexes: dict, events_mutexes: list, sliced_arrays: dict, rwlocks: dict, seqlocks: dict, colocated: dict, layout: str) -> str:
     START_COMMENT = "/* (START) AutoSync: Automatically generated */\n"
     END_COMMENT = "/* (END) AutoSync: Automatically generated */\n"
-    DECL_MUTEX = "pthread_mutex_t __DUMMY__;\n"   
-    ATTR_MUTEX = "pthread_mutexattr_t xMutexAttr;\n"
+    DECL_MUTEX = f"{sync_backend.mutex_type} __DUMMY__;\n"
+    ATTR_MUTEX = sync_backend.decl_attrs()
+    # Every lock starts a new cache line, so unrelated locks do not share it
+    ALIGNED = "_Alignas(AUTO_SYNC_CACHE_LINE_SIZE) " if layout != LAYOUT_PACKED else ""
     
-    mutexes_to_declare = list(mutexes.values())
+    # Co-located mutexes are declared in the struct of their shared-variable
+    colocated_mutexes = [f"{colocated_var}.xMutex" for colocated_var, var_type in colocated.values()]
+    mutexes_to_declare = [mutex for mutex in mutexes.values() if mutex not in colocated_mutexes]
     mutexes_to_declare = del_duplicates(mutexes_to_declare)
     mutexes_to_declare += del_duplicates(events_mutexes)    
 
     decl = START_COMMENT 
     decl += ATTR_MUTEX
     for mutex in mutexes_to_declare:
-        decl += DECL_MUTEX.replace("__DUMMY__", mutex)
+        decl += ALIGNED + DECL_MUTEX.replace("__DUMMY__", mutex)
+
+    # The struct is defined in the source file, at the line of the original declaration of the shared-variable
+    for shared_var, (colocated_var, var_type) in colocated.items():
+        decl += f"typedef struct {colocated_var}Struct\n{{\n"
+        decl += f"  _Alignas(AUTO_SYNC_CACHE_LINE_SIZE) {sync_backend.mutex_type} xMutex;\n"
+        decl += f"  {var_type} xValue;\n"
+        decl += f"}} {colocated_var}Type;\n"
+        decl += f"extern {colocated_var}Type {colocated_var};\n"
+
+    # Stripes are always padded, otherwise neighbouring stripes share a cache line and threads contend anyway
+    if get_striped_arrays(sliced_arrays):
+        decl += "typedef struct xAutoSyncPaddedMutexStruct\n{\n"
+        decl += f"  _Alignas(AUTO_SYNC_CACHE_LINE_SIZE) {sync_backend.mutex_type} xMutex;\n"
+        decl += "} xAutoSyncPaddedMutex;\n"
+    for stripes, no_of_stripes, first_access in get_striped_arrays(sliced_arrays).values():
+        decl += f"xAutoSyncPaddedMutex {stripes}[{no_of_stripes}];\n"
+
+    if RWLOCK in [rwlock_type for rwlock, rwlock_type in rwlocks.values()]:
+        decl += "pthread_rwlockattr_t xRWLockAttr;\n"
+    for rwlock, rwlock_type in del_duplicates(rwlocks.values()):
+        # The spin lock is already aligned by its type
+        decl += f"{ALIGNED if rwlock_type == RWLOCK else ''}{rwlock_type} {rwlock};\n"
+
+    # Zero initialized, i.e. no write in progress
+    for seqlock in seqlocks.values():
+        decl += f"_Alignas(AUTO_SYNC_CACHE_LINE_SIZE) atomic_uint {seqlock};\n"
 
     decl += END_COMMENT   
     return decl   
@@ -124,7 +591,7 @@ def decl_mutexes(mutexes: dict, events_mutexes: list) -> str:
 def decl_cond_var(events_cond_var: list) -> str:
     START_COMMENT = "/* (START) AutoSync: Automatically generated */\n"
     END_COMMENT = "/* (END) AutoSync: Automatically generated */\n"
-    DECL_COND_VAR = "pthread_cond_t __DUMMY__;\n"       
+    DECL_COND_VAR = f"{sync_backend.cond_type} __DUMMY__;\n"
     
     cond_var_to_declare = del_duplicates(events_cond_var)       
 
@@ -211,67 +678,1142 @@ def get_info_from_parser(path_json: str):
         auto_sync_calls = json_file[2]
         dependencies = json_file[3]
         intentions = json_file[4]
+        event_barriers = json_file[5]
+        sliced_arrays = json_file[6]
+        array_indexes = json_file[7]
+        call_graph = json_file[8]
+        global_vars = json_file[9]
+        single_threaded_sites = json_file[10]
+        # First line of every translation unit, older parsers only analysed one file
+        units = json_file[11] if len(json_file) > 11 else None
+        queues = json_file[12] if len(json_file) > 12 else {}
 
 
-    return threads_info, shared_var_types, auto_sync_calls, dependencies, intentions
+    return threads_info, shared_var_types, auto_sync_calls, dependencies, intentions, event_barriers, sliced_arrays, array_indexes, call_graph, global_vars, single_threaded_sites, units, queues
+
+
+def get_source_of_units(paths: list, units: list) -> tuple:
+    '''
+    The parser numbers the lines of a program continuously over its translation units. A program of one file is
+    generated into temp.c. The files of a bigger program are concatenated into one source with the lines of the
+    parser, and every file is generated into a file with its name in the workspace.
+    Returns the path of the source and the generated file of every first line of a translation unit.
+    EXAMPLE:
+        ["main.c", "worker.c"] -> ("../05_Workspace/_AutoSyncUnits.c", {1: "../05_Workspace/main.c", 161: "../05_Workspace/worker.c"})
+    '''
+    if units is None:
+        units = [[paths[0], 0]] if len(paths) == 1 else []
+    if [os.path.abspath(path) for path in paths] != [os.path.abspath(path) for path, offset in units]:
+        print(f"[CODE GENERATOR ERROR] The parser analysed {[path for path, offset in units]}, the same files have to be generated together")
+        exit(1)
+    if len(paths) == 1:
+        return paths[0], {1: "../05_Workspace/temp.c"}
+
+    outputs = {offset + 1: os.path.join("../05_Workspace", os.path.basename(path)) for path, offset in units}
+    if len(set(outputs.values())) != len(outputs):
+        print(f"[CODE GENERATOR ERROR] The generated files of {paths} would have the same name")
+        exit(1)
+
+    source_path = "../05_Workspace/_AutoSyncUnits.c"
+    with open(source_path, "w") as source:
+        for path in paths:
+            with open(path, "r") as unit:
+                lines = unit.readlines()
+            # The last line of a unit must not run into the first line of the next one
+            if lines and not lines[-1].endswith("\n"):
+                lines[-1] += "\n"
+            source.writelines(lines)
+    return source_path, outputs
+
+
+def get_site_line(site) -> int:
+    '''
+    Get the line of an AutoSync call. The parser identifies a call by its line, the following calls of the same line
+    by their line and column.
+    EXAMPLE:
+        "104:37" -> 104
+    '''
+    return int(str(site).split(":")[0])
+
+
+def get_site_order(site) -> tuple:
+    # The call identified by its line is the first one of the line
+    line_no, _, column = str(site).partition(":")
+    return (int(line_no), int(column or 0))
+
+
+# An AutoSync call of the source: its node, the source range of its statement and the nodes that enclose the statement
+class CallSite():
+    def __init__(self, site: str, node: c_ast.FuncCall, line: int, func: str, ancestors: list):
+        self.site = site
+        self.func_sig = node.name.name
+        self.node = node
+        self.func = func
+        # From the FuncDef to the node that holds the statement
+        self.ancestors = ancestors
+        # The call starts at its line and column, the statement ends at the column of its semicolon
+        self.line = line
+        self.column = node.coord.column
+        self.end_line = None
+        self.end_column = None
+        # A statement of a block, otherwise the only statement of an if, a loop or a label
+        self.braced = True
+
+
+    def get_args(self) -> list:
+        '''
+        Get the arguments of the call as C code.
+        EXAMPLE:
+            ["&uiCountLocal", "&uiCountOccurrences", "sizeof(uiCountLocal)", "xNoSpecialIntention"]
+        '''
+        generator = c_generator.CGenerator()
+        return [generator.visit(arg) for arg in self.node.args.exprs]
+
+
+    def is_own_line(self, lines: list) -> bool:
+        '''
+        Check if the call is a statement of a block and the only code of its line (comments aside), so the whole
+        line can be replaced.
+        '''
+        before = lines[self.line - 1][:self.column - 1]
+        after = re.sub(r"/\*.*?\*/|//.*", "", lines[self.end_line - 1][self.end_column:])
+        return self.braced and self.line == self.end_line and not before.strip() and not after.strip()
+
+
+# Find the AutoSync calls of a translation unit and the nodes that enclose them
+class CallSiteVisitor(c_ast.NodeVisitor):
+    def __init__(self, filename: str, offset: int):
+        self.filename = filename
+        self.offset = offset
+        self.call_sites = {}
+        self.ancestors = []
+        self.func = None
+
+
+    def generic_visit(self, node):
+        self.ancestors.append(node)
+        for name, child in node.children():
+            self.visit(child)
+        self.ancestors.pop()
+
+
+    def visit_FuncDef(self, node):
+        self.func = node.decl.name
+        self.generic_visit(node)
+        self.func = None
+
+
+    def visit_FuncCall(self, node):
+        # Calls in the included headers are not part of the unit
+        if not isinstance(node.name, c_ast.ID) or node.name.name not in AUTO_SYNC_SITES or node.coord.file != self.filename:
+            self.generic_visit(node)
+            return
+
+        line_no = int(node.coord.line) + self.offset
+        site = str(line_no) if str(line_no) not in self.call_sites else f"{line_no}:{node.coord.column}"
+        call_site = CallSite(site, node, line_no, self.func, list(self.ancestors))
+
+        parent = self.ancestors[-1]
+        if isinstance(parent, (c_ast.If, c_ast.For, c_ast.While, c_ast.DoWhile, c_ast.Label)) and \
+           node in [getattr(parent, attr, None) for attr in ["iftrue", "iffalse", "stmt"]]:
+            call_site.braced = False
+        elif not (isinstance(parent, c_ast.Compound) and any(node is item for item in parent.block_items or [])) and \
+             not (isinstance(parent, (c_ast.Case, c_ast.Default)) and any(node is item for item in parent.stmts or [])):
+            print(f"[CODE GENERATOR ERROR] The result of {node.name.name} in line {line_no} is used, the call has to be a statement")
+            exit(1)
+        self.call_sites[site] = call_site
+
+
+def iter_code(lines: list, line_no: int, column: int):
+    '''
+    Iterate over the code of the source from a line and column (both start at 1). Comments and the content of
+    string and character literals are skipped.
+    Yields the line, the column and the character.
+    '''
+    comment = False
+    quote = None
+    for line_idx in range(line_no - 1, len(lines)):
+        text = lines[line_idx]
+        idx = column - 1 if line_idx == line_no - 1 else 0
+        while idx < len(text):
+            char = text[idx]
+            if comment:
+                if text.startswith("*/", idx):
+                    comment = False
+                    idx += 1
+            elif quote:
+                if char == "\\":
+                    idx += 1
+                elif char == quote:
+                    quote = None
+            elif text.startswith("//", idx):
+                break
+            elif text.startswith("/*", idx):
+                comment = True
+                idx += 1
+            elif char in "\"'":
+                quote = char
+            else:
+                yield line_idx + 1, idx + 1, char
+            idx += 1
 
 
-def create_auto_sync_impl(events_mutexes: list, events_cond_var: list, mutexes: dict, existing_shared_var: set, auto_sync_unique_calls: list):
+def get_statement_end(lines: list, line_no: int, column: int) -> tuple:
+    '''
+    Get the end of the statement of a call from its line and column (both start at 1): the semicolon after the
+    closing parenthesis of the call.
+    Returns None if the call is not followed by a semicolon.
+    EXAMPLE:
+        ["  iAutoSyncRead(&localN, &N,\n", "                sizeof(N), xIntentionN); /* N */\n"], 1, 3 -> (2, 40)
+    '''
+    depth = 0
+    closed = False
+    for end_line, end_column, char in iter_code(lines, line_no, column):
+        if closed:
+            if char == ";":
+                return (end_line, end_column)
+            if not char.isspace():
+                return None
+        elif char == "(":
+            depth += 1
+        elif char == ")":
+            depth -= 1
+            closed = depth == 0
+    return None
+
+
+def get_block_end(lines: list, line_no: int, column: int) -> tuple:
+    '''
+    Get the line and column of the closing brace of the first block after a line and column, e.g. the body of a
+    loop from the start of the loop. Braces in the parentheses of the loop header are not the block.
+    Returns None if the block is not closed.
+    EXAMPLE:
+        ["  for (i = 0; i < N; i++) {\n", "    x++;\n", "  }\n"], 1, 3 -> (3, 3)
+    '''
+    depth = 0
+    parentheses = 0
+    for end_line, end_column, char in iter_code(lines, line_no, column):
+        if depth == 0 and char in "()":
+            parentheses += 1 if char == "(" else -1
+        elif char == "{" and (depth or not parentheses):
+            depth += 1
+        elif char == "}":
+            depth -= 1
+            if depth == 0:
+                return (end_line, end_column)
+    return None
+
+
+def iter_nodes(node: c_ast.Node):
+    # The node and all the nodes below it
+    yield node
+    for name, child in node.children():
+        yield from iter_nodes(child)
+
+
+def get_call_sites(units: list, auto_sync_calls: dict) -> dict:
+    '''
+    Parse the translation units again to find the AutoSync calls of the parser in the AST. The generated code only
+    replaces the source range of the statement of a call, so the rest of the source is kept as it is.
+    Returns a dictionary with the call site of every AutoSync call.
+    EXAMPLE:
+        "154": CallSite of iAutoSyncReadToUpdate(&uiCountLocal, &uiCountOccurrences, ...) in SearchThread
+    '''
+    call_sites = dict()
+    for path, offset in units:
+        ast = parse_file(path, use_cpp=True,
+                               cpp_path='gcc',
+                               cpp_args=['-E', r'-Iutils/fake_libc_include'])
+        visitor = CallSiteVisitor(path, offset)
+        visitor.visit(ast)
+
+        with open(path, "r") as source:
+            lines = source.readlines()
+        for site, call_site in visitor.call_sites.items():
+            line_no = call_site.line - offset
+            end = None
+            if lines[line_no - 1].startswith(call_site.func_sig, call_site.column - 1):
+                end = get_statement_end(lines, line_no, call_site.column)
+            if end is None:
+                print(f"[CODE GENERATOR ERROR] {call_site.func_sig} in line {call_site.line} is not written as a call statement (e.g. it comes from a macro)")
+                exit(1)
+            call_site.end_line, call_site.end_column = end[0] + offset, end[1]
+        call_sites.update(visitor.call_sites)
+
+    if set(call_sites) != set(auto_sync_calls):
+        print(f"[CODE GENERATOR ERROR] The AutoSync calls of the lines {sorted(set(call_sites) ^ set(auto_sync_calls), key=get_site_order)} " + \
+              "do not match the parser output, please run the parser again")
+        exit(1)
+    return call_sites
+
+
+# Find the threads that main creates and joins, the other calls of main and which functions take parameters
+class ThreadCreationVisitor(CallSiteVisitor):
+    def __init__(self, filename: str, offset: int):
+        super().__init__(filename, offset)
+        self.thread_calls = []
+        self.main_calls = []
+        self.has_params = {}
+
+
+    def visit_Decl(self, node):
+        # f(void) and f() do not take the argument of their thread
+        if isinstance(node.type, c_ast.FuncDecl) and node.name:
+            params = node.type.args.params if node.type.args is not None else []
+            void = len(params) == 1 and isinstance(params[0], c_ast.Typename) and isinstance(params[0].type, c_ast.TypeDecl) and \
+                   getattr(params[0].type.type, "names", None) == ["void"]
+            self.has_params[node.name] = bool(params) and not void
+        self.generic_visit(node)
+
+
+    def visit_FuncCall(self, node):
+        if isinstance(node.name, c_ast.ID) and node.coord.file == self.filename:
+            line_no = int(node.coord.line) + self.offset
+            call_site = CallSite(str(line_no), node, line_no, self.func, list(self.ancestors))
+            if node.name.name in [FUNC_CREATE_TASK, FUNC_JOIN_TASK]:
+                self.thread_calls.append(call_site)
+            elif self.func == "main":
+                self.main_calls.append(call_site)
+        self.generic_visit(node)
+
+
+def get_call_end(lines: list, line_no: int, column: int) -> tuple:
+    '''
+    Get the line and column of the closing parenthesis of a call from its line and column (both start at 1).
+    Returns None if the parenthesis is not closed.
+    EXAMPLE:
+        ["  iRetVal = pthread_join(xThreadHandle[i], NULL);\n"], 1, 13 -> (1, 48)
+    '''
+    depth = 0
+    for end_line, end_column, char in iter_code(lines, line_no, column):
+        if char == "(":
+            depth += 1
+        elif char == ")":
+            depth -= 1
+            if depth == 0:
+                return (end_line, end_column)
+    return None
+
+
+def get_call_column(line: str, func: str, column: int) -> int:
+    '''
+    Get the column of a call in its line. The column of pycparser is shifted if a macro in front of the call
+    expands to text of another length, then the call is found by its name if it is the only one of the line.
+    Returns None if the call is not found.
+    EXAMPLE:
+        "  for (int i = 0; i < NO_OF_THREADS; i++) pthread_join(xThreadHandle[i], NULL);\n", "pthread_join", 41 -> 44
+    '''
+    if line.startswith(func, column - 1):
+        return column
+    matches = list(re.finditer(r"\b" + re.escape(func) + r"\s*\(", line))
+    return matches[0].start() + 1 if len(matches) == 1 else None
+
+
+def get_thread_func(expr: c_ast.Node) -> str:
+    '''
+    Get the function started by pthread_create, without the casts and the address operator.
+    EXAMPLE:
+        (void * (*)(void *))(SlaveStart) -> "SlaveStart"
+    '''
+    while isinstance(expr, c_ast.Cast) or (isinstance(expr, c_ast.UnaryOp) and expr.op == "&"):
+        expr = expr.expr
+    return expr.name if isinstance(expr, c_ast.ID) else None
+
+
+def assign_parallel_region(units: list, path: str, reductions: dict) -> tuple:
+    '''
+    Logic for running the threads of main in an OpenMP parallel region, so they are taken from the thread pool of
+    the OpenMP runtime. main must create all threads with pthread_create and they must run the same function.
+    A pthread_create only keeps the argument of its thread and the side effects of the handle, the threads are
+    started together in place of the call of main to the thread function if main takes part itself, otherwise in
+    front of the statement of the first pthread_join. The thread with the number of a pthread_create gets its
+    argument and the last thread makes the call of main. The parallel region joins the threads, so every
+    pthread_join becomes 0.
+    Returns the generated code of the source lines that change and the thread function.
+    EXAMPLE:
+        {"90": "    iRetVal = ((void)(&xThreadHandle[i]), pvAutoSyncOmpArgs[uiAutoSyncOmpThreads++] = (void*)(&xSlices[i]), 0);\n",
+         "91": "", "92": "", "93": "", "97": "  #pragma omp parallel num_threads(uiAutoSyncOmpThreads)\n  {...}\n  for (...)\n", ...},
+        "SearchThread"
+    '''
+    with open(path, "r") as source:
+        lines = source.readlines()
+
+    thread_calls = []
+    main_calls = []
+    has_params = dict()
+    for unit_path, offset in units:
+        ast = parse_file(unit_path, use_cpp=True,
+                                    cpp_path='gcc',
+                                    cpp_args=['-E', r'-Iutils/fake_libc_include'])
+        visitor = ThreadCreationVisitor(unit_path, offset)
+        visitor.visit(ast)
+        thread_calls += visitor.thread_calls
+        main_calls += visitor.main_calls
+        has_params.update(visitor.has_params)
+
+    creations = [call_site for call_site in thread_calls if call_site.func_sig == FUNC_CREATE_TASK]
+    joins = [call_site for call_site in thread_calls if call_site.func_sig == FUNC_JOIN_TASK]
+    thread_funcs = {get_thread_func(call_site.node.args.exprs[2]) if len(call_site.node.args.exprs) == 4 else None for call_site in creations}
+    if not creations or any(call_site.func != "main" for call_site in thread_calls) or len(thread_funcs) != 1 or None in thread_funcs:
+        print("[CODE GENERATOR ERROR] The OpenMP backend needs main to create and join the threads of a single function with pthread_create")
+        exit(1)
+    thread_func = thread_funcs.pop()
+
+    thread_sections = dict()
+    def replace_call(call_site: CallSite, code: str):
+        end = None
+        call_site.column = get_call_column(lines[call_site.line - 1], call_site.func_sig, call_site.column)
+        if call_site.column is not None:
+            end = get_call_end(lines, call_site.line, call_site.column)
+        if end is None or any(str(line_no) in thread_sections for line_no in range(call_site.line, end[0] + 1)):
+            print(f"[CODE GENERATOR ERROR] {call_site.func_sig} in line {call_site.line} has to be written as a call (e.g. not in a macro) " + \
+                  "and be the only one of its lines")
+            exit(1)
+        thread_sections[str(call_site.line)] = lines[call_site.line - 1][:call_site.column - 1] + code + lines[end[0] - 1][end[1]:]
+        for line_no in range(call_site.line + 1, end[0] + 1):
+            thread_sections[str(line_no)] = ""
+
+    # The calls return 0 if their result is used, a statement has no result so that it is warning-free
+    def is_statement(call_site: CallSite) -> bool:
+        return isinstance(call_site.ancestors[-1], (c_ast.Compound, c_ast.If, c_ast.For, c_ast.While, c_ast.DoWhile,
+                                                    c_ast.Label, c_ast.Case, c_ast.Default))
+
+    for call_site in creations:
+        args = call_site.get_args()
+        result = "" if is_statement(call_site) else ", 0"
+        replace_call(call_site, f"((void)({args[0]}), pvAutoSyncOmpArgs[uiAutoSyncOmpThreads++] = (void*)({args[3]}){result})")
+    for call_site in joins:
+        replace_call(call_site, "(void)0" if is_statement(call_site) else "0")
+
+    # main takes part as the last thread if it calls the thread function itself
+    direct_calls = [call_site for call_site in main_calls if call_site.func_sig == thread_func]
+    if len(direct_calls) > 1:
+        print(f"[CODE GENERATOR ERROR] main calls {thread_func} in the lines {[call_site.line for call_site in direct_calls]}, " + \
+              "the OpenMP backend only supports one call")
+        exit(1)
+    if direct_calls:
+        direct_call = direct_calls[0]
+        parent = direct_call.ancestors[-1]
+        direct_call.column = get_call_column(lines[direct_call.line - 1], thread_func, direct_call.column)
+        end = get_statement_end(lines, direct_call.line, direct_call.column) if direct_call.column is not None else None
+        if end is not None:
+            direct_call.end_line, direct_call.end_column = end
+        if end is None or not (isinstance(parent, c_ast.Compound) and any(direct_call.node is item for item in parent.block_items)) or \
+           not direct_call.is_own_line(lines):
+            print(f"[CODE GENERATOR ERROR] The call of main to {thread_func} in line {direct_call.line} has to be the only statement of its line")
+            exit(1)
+        region_line = direct_call.line
+    elif joins:
+        # The statement of main that holds the first pthread_join
+        first_join = min(joins, key=lambda call_site: (call_site.line, call_site.column))
+        nodes = first_join.ancestors + [first_join.node]
+        statement = nodes[next(idx for idx, node in enumerate(nodes) if isinstance(node, c_ast.FuncDef)) + 2]
+        region_line = statement.coord.line + first_join.line - first_join.node.coord.line
+        if lines[region_line - 1][:statement.coord.column - 1].strip():
+            print(f"[CODE GENERATOR ERROR] The statement of pthread_join in line {region_line} has to start its line")
+            exit(1)
+    else:
+        print(f"[CODE GENERATOR ERROR] The OpenMP backend needs main to join the threads of {thread_func}")
+        exit(1)
+    if region_line <= max(call_site.line for call_site in creations):
+        print(f"[CODE GENERATOR ERROR] The threads of {thread_func} have to be created before line {region_line}")
+        exit(1)
+
+    line = lines[region_line - 1]
+    indent = line[:len(line) - len(line.lstrip())]
+    thread_call = f"{thread_func}({'pvAutoSyncOmpArgs[omp_get_thread_num()]' if has_params.get(thread_func, True) else ''});\n"
+    code = f"{indent}{AUTO_SYNC_GENERATED}"
+    # The barriers of the events need the whole team, the runtime must not give fewer threads
+    code += f"{indent}omp_set_dynamic(0);\n"
+    code += f"{indent}#pragma omp parallel num_threads(uiAutoSyncOmpThreads{' + 1' if direct_calls else ''})\n"
+    code += f"{indent}{{\n"
+    main_call = f"{c_generator.CGenerator().visit(direct_calls[0].node)};\n" if direct_calls else thread_call
+    if main_call != thread_call:
+        code += f"{indent}  if (omp_get_thread_num() < (int)uiAutoSyncOmpThreads) {{\n"
+        code += f"{indent}    {thread_call}"
+        code += f"{indent}  }} else {{\n"
+        code += f"{indent}    {main_call}"
+        code += f"{indent}  }}\n"
+    else:
+        code += f"{indent}  {thread_call}"
+    if get_typed_reductions(reductions):
+        # The threads of the pool do not exit, their reductions are flushed when they leave the region
+        code += f"{indent}  vAutoSyncReduceFlushThread();\n"
+    code += f"{indent}}}\n"
+    thread_sections[str(region_line)] = code + ("" if direct_calls else thread_sections.get(str(region_line), line))
+
+    print(f"!!! [CODE GENERATOR INFO] The threads of {thread_func} run in an OpenMP parallel region started in line {region_line}")
+    return thread_sections, thread_func
+
+
+def create_auto_sync_impl(events_mutexes: list, events_cond_var: list, mutexes: dict, existing_shared_var: set, auto_sync_unique_calls: list, reductions: dict, reduce_events: dict, event_sync_mechanisms: dict, sliced_arrays: dict, rwlocks: dict, mutex_types: dict, queues: dict, combined: dict, profile_sites: list):
     # Generate C code implementation
+    barrier_events = get_barrier_events(event_sync_mechanisms)
     with open("../05_Workspace/_AutoSync.c", "w") as f:
+        # Needed for syscall(), the futex constants, PTHREAD_MUTEX_ADAPTIVE_NP and pthread_rwlockattr_setkind_np()
+        f.write('#define _GNU_SOURCE\n')
         f.write('#include <pthread.h>\n')
         f.write('#include <assert.h>\n')
+        if get_typed_reductions(reductions) or barrier_events or queues or combined:
+            f.write('#include <stdatomic.h>\n')
+        if barrier_events or sync_backend is SYNC_BACKENDS[BACKEND_FUTEX]:
+            f.write('#include <sched.h>\n')
+            f.write('#include <limits.h>\n')
+            f.write('#ifdef __linux__\n')
+            f.write('#include <unistd.h>\n')
+            f.write('#include <sys/syscall.h>\n')
+            f.write('#include <linux/futex.h>\n')
+            f.write('#endif\n')
         f.write('#include "_AutoSync.h"\n')
 
-        f.write(create_auto_sync_create(events_mutexes, events_cond_var, mutexes))
-        f.write(create_auto_sync_destroy(events_mutexes, events_cond_var, mutexes)) 
+        f.write(sync_backend.create_impl())
+        if profile_sites is not None:
+            f.write(create_auto_sync_profile_dump(profile_sites))
+        f.write(create_auto_sync_reduce(reductions, mutexes, reduce_events))
+        f.write(create_auto_sync_barriers(barrier_events))
+        f.write(create_auto_sync_queues(queues))
+        f.write(create_auto_sync_combining(combined))
+        f.write(create_auto_sync_create(events_mutexes, events_cond_var, mutexes, reductions, sliced_arrays, rwlocks, mutex_types))
+        f.write(create_auto_sync_destroy(events_mutexes, events_cond_var, mutexes, reductions, sliced_arrays, rwlocks, profile_sites is not None)) 
 
         #f.write(c_code_no_include)
 
-def create_auto_sync_create(events_mutexes: list, events_cond_var: list, mutexes: dict) -> str:    
+def get_typed_reductions(reductions: dict) -> dict:
+    '''
+    Get the reductions that are accumulated per thread (i.e. the type of the shared-variable is known)
+    '''
+    return {shared_var: reduction for shared_var, reduction in reductions.items() if reduction[0]}
+
+
+def create_auto_sync_reduce(reductions: dict, mutexes: dict, reduce_events: dict) -> str:
+    '''
+    Create the per-thread accumulators of the reductions.
+    Every thread accumulates in its own cache line padded slot. The slots are combined once by a log(P) tree
+    when the threads proceed on an event, and the slot of a thread that finishes is combined at thread exit.
+    The leaves of the tree are the threads in the order of their arrival at the event, not their slots. Every
+    event has its own tree, so the events can be proceeded on by different quantities of threads.
+    '''
+    typed_reductions = get_typed_reductions(reductions)
+    if not typed_reductions:
+        return ""
+
+    code = f"""
+{AUTO_SYNC_GENERATED}static _Thread_local uint32_t uiAutoSyncSlot = UINT32_MAX;
+static atomic_uint uiAutoSyncNextSlot;
+static pthread_key_t xAutoSyncThreadExitKey;
+
+static uint32_t uiAutoSyncGetSlot(void)
+{{
+  if (uiAutoSyncSlot == UINT32_MAX) {{
+    uiAutoSyncSlot = atomic_fetch_add_explicit(&uiAutoSyncNextSlot, 1, memory_order_relaxed);
+    /* The value must not be NULL, otherwise the thread exit handler is not called */
+    pthread_setspecific(xAutoSyncThreadExitKey, (void*)((uintptr_t)uiAutoSyncSlot + 1));
+  }}
+  return uiAutoSyncSlot;
+}}
+
+typedef struct xAutoSyncReduceNodeStruct
+{{
+  _Alignas(AUTO_SYNC_CACHE_LINE_SIZE) atomic_uint uiArrived;
+  uint32_t uiPartialSlot[2];
+}} xAutoSyncReduceNode;
+"""
+    combine_events = get_combine_events(reduce_events)
+    thread_exit = ""
+    for shared_var, (var_type, reduce_op) in typed_reductions.items():
+        var_id = c_identifier(shared_var)
+        mutex = mutexes[shared_var]
+        slots = f"xAutoSyncReduceSlots_{var_id}"
+        shared = f"pxAutoSyncReduceShared_{var_id}"
+        combine_slots = REDUCE_OPS[reduce_op].format(a=f"{slots}[uiSlot].xValue", b=f"{slots}[uiOther].xValue")
+        thread_exit += f"  vAutoSyncReduceFlush_{var_id}(uiSlot);\n"
+
+        code += f"""
+static struct {{ _Alignas(AUTO_SYNC_CACHE_LINE_SIZE) {var_type} xValue; bool bValid; }} {slots}[AUTO_SYNC_MAX_THREADS];
+static {var_type}* _Atomic {shared};
+
+static void vAutoSyncReduceFlush_{var_id}(uint32_t uiSlot)
+{{
+  {var_type}* pxShared = atomic_load_explicit(&{shared}, memory_order_relaxed);
+
+  if (uiSlot < AUTO_SYNC_MAX_THREADS && {slots}[uiSlot].bValid) {{
+    {sync_backend.lock(f"&{mutex}")};
+    *pxShared = {REDUCE_OPS[reduce_op].format(a="*pxShared", b=f"{slots}[uiSlot].xValue")};
+    {sync_backend.unlock(f"&{mutex}")};
+    {slots}[uiSlot].bValid = false;
+  }}
+}}
+
+int8_t iAutoSyncReduce_{var_id}(void* pvSharedVar, void* pvValue)
+{{
+  uint32_t uiSlot = uiAutoSyncGetSlot();
+  {var_type} xValue;
+
+  memcpy(&xValue, pvValue, sizeof(xValue));
+  if (atomic_load_explicit(&{shared}, memory_order_relaxed) == NULL) {{
+    atomic_store_explicit(&{shared}, ({var_type}*)pvSharedVar, memory_order_relaxed);
+  }}
+
+  if (uiSlot >= AUTO_SYNC_MAX_THREADS) {{
+    /* No private slot left, combine directly */
+    {sync_backend.lock(f"&{mutex}")};
+    *({var_type}*)pvSharedVar = {REDUCE_OPS[reduce_op].format(a=f"*({var_type}*)pvSharedVar", b="xValue")};
+    {sync_backend.unlock(f"&{mutex}")};
+  }} else if ({slots}[uiSlot].bValid) {{
+    {slots}[uiSlot].xValue = {REDUCE_OPS[reduce_op].format(a=f"{slots}[uiSlot].xValue", b="xValue")};
+  }} else {{
+    {slots}[uiSlot].xValue = xValue;
+    {slots}[uiSlot].bValid = true;
+  }}
+
+  return AUTO_SYNC_OK;
+}}
+"""
+        if shared_var not in combine_events:
+            # Only combined at thread exit
+            continue
+
+        code += f"""
+static int8_t iAutoSyncReduceTree_{var_id}(atomic_ullong* puiTicket, xAutoSyncReduceNode* pxNodes, uint32_t uiNoOfThreads)
+{{
+  uint32_t uiSlot = uiAutoSyncGetSlot();
+  uint32_t uiLeaf;
+  uint32_t uiLevel;
+
+  if (uiNoOfThreads > AUTO_SYNC_MAX_THREADS) {{
+    /* Tree is too small, combine directly */
+    vAutoSyncReduceFlush_{var_id}(uiSlot);
+    return AUTO_SYNC_OK;
+  }}
+
+  /* The threads of an episode draw consecutive tickets, no thread draws one of the next episode before all of
+     them proceeded. A thread without a slot still takes its leaf, so that every node is reached twice */
+  uiLeaf = atomic_fetch_add_explicit(puiTicket, 1, memory_order_relaxed) % uiNoOfThreads;
+
+  /* The second thread arriving at a node combines the slot of its sibling subtree and goes up */
+  for (uiLevel = 0; (1u << uiLevel) < uiNoOfThreads; uiLevel++) {{
+    uint32_t uiHalf = 1u << uiLevel;
+    uint32_t uiSide = (uiLeaf & uiHalf) ? 1 : 0;
+    uint32_t uiGroup = uiLeaf >> (uiLevel + 1);
+    xAutoSyncReduceNode* pxNode;
+    uint32_t uiOther;
+
+    if (uiSide == 0 && (uiGroup << (uiLevel + 1)) + uiHalf >= uiNoOfThreads) {{
+      /* The sibling subtree is empty */
+      continue;
+    }}
+
+    pxNode = &pxNodes[AUTO_SYNC_MAX_THREADS - (AUTO_SYNC_MAX_THREADS >> uiLevel) + uiGroup];
+    pxNode->uiPartialSlot[uiSide] = uiSlot;
+    if (atomic_fetch_add_explicit(&pxNode->uiArrived, 1, memory_order_acq_rel) == 0) {{
+      return AUTO_SYNC_OK;
+    }}
+
+    uiOther = pxNode->uiPartialSlot[1 - uiSide];
+    atomic_store_explicit(&pxNode->uiArrived, 0, memory_order_relaxed);
+    if (uiOther >= AUTO_SYNC_MAX_THREADS || !{slots}[uiOther].bValid) {{
+      continue;
+    }}
+    if (uiSlot >= AUTO_SYNC_MAX_THREADS) {{
+      /* No slot to hold the partial result, combine the sibling directly */
+      vAutoSyncReduceFlush_{var_id}(uiOther);
+    }} else {{
+      {slots}[uiSlot].xValue = {slots}[uiSlot].bValid ? ({combine_slots}) : {slots}[uiOther].xValue;
+      {slots}[uiSlot].bValid = true;
+      {slots}[uiOther].bValid = false;
+    }}
+  }}
+
+  /* Root of the tree */
+  vAutoSyncReduceFlush_{var_id}(uiSlot);
+
+  return AUTO_SYNC_OK;
+}}
+"""
+        for event in combine_events.get(shared_var, []):
+            code += f"""
+static xAutoSyncReduceNode xAutoSyncReduceNodes_{event}_{var_id}[AUTO_SYNC_MAX_THREADS];
+static atomic_ullong uiAutoSyncReduceTicket_{event}_{var_id};
+
+int8_t iAutoSyncReduceCombine_{event}_{var_id}(uint32_t uiNoOfThreads)
+{{
+  return iAutoSyncReduceTree_{var_id}(&uiAutoSyncReduceTicket_{event}_{var_id}, xAutoSyncReduceNodes_{event}_{var_id}, uiNoOfThreads);
+}}
+"""
+
+    code += f"""
+static void vAutoSyncThreadExit(void* pvSlot)
+{{
+  uint32_t uiSlot = (uint32_t)((uintptr_t)pvSlot - 1);
+
+{thread_exit}}}
+"""
+    if sync_backend.openmp:
+        # The threads of the OpenMP pool do not exit, they flush their slots when they leave the parallel region
+        code += """
+void vAutoSyncReduceFlushThread(void)
+{
+  if (uiAutoSyncSlot != UINT32_MAX) {
+    vAutoSyncThreadExit((void*)((uintptr_t)uiAutoSyncSlot + 1));
+  }
+}
+"""
+    return code
+
+
+def create_auto_sync_queues(queues: dict) -> str:
+    '''
+    Create the ring buffers of the queues. The items are stored in the array of the queue, the indices are kept
+    here on their own cache lines, so that producers and consumers do not invalidate each other's index.
+    A single producer and a single consumer only publish their index, the other one is cached and only loaded again
+    when the queue looks full (or empty). Several producers or consumers claim a position of the ring with a CAS and
+    wait for the sequence number of its slot (Vyukov's bounded MPMC queue).
+    '''
+    code = ""
+    for queue, (capacity, variant) in queues.items():
+        queue_id = c_identifier(queue)
+        ring = f"xAutoSyncQueue_{queue_id}"
+        slot = f"(char*)pvQueue + (uiPos & {capacity - 1}) * xSizeData"
+
+        if variant == QUEUE_SPSC:
+            code += f"""
+{AUTO_SYNC_GENERATED}static struct {{
+  _Alignas(AUTO_SYNC_CACHE_LINE_SIZE) atomic_size_t uiTail; /* Written by the producer */
+  size_t uiCachedHead;
+  _Alignas(AUTO_SYNC_CACHE_LINE_SIZE) atomic_size_t uiHead; /* Written by the consumer */
+  size_t uiCachedTail;
+}} {ring};
+
+int8_t {AUTO_SYNC_ENQUEUE}_{queue_id}(void* pvQueue, void* pvItem, size_t xSizeData)
+{{
+  size_t uiPos = atomic_load_explicit(&{ring}.uiTail, memory_order_relaxed);
+  uint32_t uiSpin = 0;
+
+  while (uiPos - {ring}.uiCachedHead == {capacity}) {{
+    {ring}.uiCachedHead = atomic_load_explicit(&{ring}.uiHead, memory_order_acquire);
+    if (uiPos - {ring}.uiCachedHead == {capacity}) {{
+      vAutoSyncSpinPause(&uiSpin);
+    }}
+  }}
+  memcpy({slot}, pvItem, xSizeData);
+  atomic_store_explicit(&{ring}.uiTail, uiPos + 1, memory_order_release);
+
+  return AUTO_SYNC_OK;
+}}
+
+int8_t {AUTO_SYNC_DEQUEUE}_{queue_id}(void* pvItem, void* pvQueue, size_t xSizeData)
+{{
+  size_t uiPos = atomic_load_explicit(&{ring}.uiHead, memory_order_relaxed);
+  uint32_t uiSpin = 0;
+
+  while (uiPos == {ring}.uiCachedTail) {{
+    {ring}.uiCachedTail = atomic_load_explicit(&{ring}.uiTail, memory_order_acquire);
+    if (uiPos == {ring}.uiCachedTail) {{
+      vAutoSyncSpinPause(&uiSpin);
+    }}
+  }}
+  memcpy(pvItem, {slot}, xSizeData);
+  atomic_store_explicit(&{ring}.uiHead, uiPos + 1, memory_order_release);
+
+  return AUTO_SYNC_OK;
+}}
+"""
+        else:
+            # The sequence numbers are stored without the index of their slot, so the zero-initialized queue is empty
+            code += f"""
+{AUTO_SYNC_GENERATED}static struct {{
+  _Alignas(AUTO_SYNC_CACHE_LINE_SIZE) atomic_size_t uiTail;
+  _Alignas(AUTO_SYNC_CACHE_LINE_SIZE) atomic_size_t uiHead;
+  _Alignas(AUTO_SYNC_CACHE_LINE_SIZE) atomic_size_t uiSeq[{capacity}];
+}} {ring};
+
+int8_t {AUTO_SYNC_ENQUEUE}_{queue_id}(void* pvQueue, void* pvItem, size_t xSizeData)
+{{
+  size_t uiPos = atomic_load_explicit(&{ring}.uiTail, memory_order_relaxed);
+  uint32_t uiSpin = 0;
+
+  for (;;) {{
+    intptr_t iDiff = (intptr_t)(atomic_load_explicit(&{ring}.uiSeq[uiPos & {capacity - 1}], memory_order_acquire) -
+                                (uiPos & ~(size_t){capacity - 1}));
+    if (iDiff == 0) {{
+      /* The slot is free in this round of the ring */
+      if (atomic_compare_exchange_weak_explicit(&{ring}.uiTail, &uiPos, uiPos + 1, memory_order_relaxed, memory_order_relaxed)) {{
+        break;
+      }}
+    }} else {{
+      if (iDiff < 0) {{
+        /* The item of the previous round was not dequeued, the queue is full */
+        vAutoSyncSpinPause(&uiSpin);
+      }}
+      uiPos = atomic_load_explicit(&{ring}.uiTail, memory_order_relaxed);
+    }}
+  }}
+  memcpy({slot}, pvItem, xSizeData);
+  atomic_store_explicit(&{ring}.uiSeq[uiPos & {capacity - 1}], (uiPos & ~(size_t){capacity - 1}) + 1, memory_order_release);
+
+  return AUTO_SYNC_OK;
+}}
+
+int8_t {AUTO_SYNC_DEQUEUE}_{queue_id}(void* pvItem, void* pvQueue, size_t xSizeData)
+{{
+  size_t uiPos = atomic_load_explicit(&{ring}.uiHead, memory_order_relaxed);
+  uint32_t uiSpin = 0;
+
+  for (;;) {{
+    intptr_t iDiff = (intptr_t)(atomic_load_explicit(&{ring}.uiSeq[uiPos & {capacity - 1}], memory_order_acquire) -
+                                ((uiPos & ~(size_t){capacity - 1}) + 1));
+    if (iDiff == 0) {{
+      /* The slot holds the item of this round of the ring */
+      if (atomic_compare_exchange_weak_explicit(&{ring}.uiHead, &uiPos, uiPos + 1, memory_order_relaxed, memory_order_relaxed)) {{
+        break;
+      }}
+    }} else {{
+      if (iDiff < 0) {{
+        /* The item of this round was not enqueued, the queue is empty */
+        vAutoSyncSpinPause(&uiSpin);
+      }}
+      uiPos = atomic_load_explicit(&{ring}.uiHead, memory_order_relaxed);
+    }}
+  }}
+  memcpy(pvItem, {slot}, xSizeData);
+  atomic_store_explicit(&{ring}.uiSeq[uiPos & {capacity - 1}], (uiPos & ~(size_t){capacity - 1}) + {capacity}, memory_order_release);
+
+  return AUTO_SYNC_OK;
+}}
+"""
+    return code
+
+
+def create_auto_sync_combining(combined: dict) -> str:
+    '''
+    Create the publication slots and the combine functions of the flat-combined shared-variables.
+    A thread posts the operation of its update in its own cache line padded slot. The thread that gets the mutex of
+    the shared-variable applies all posted operations in one pass and hands every thread the value before its
+    operation, the other threads wait until their slot was served or the mutex is free again.
+    Threads without a slot apply their operation on their own.
+    '''
+    if not combined:
+        return ""
+
+    code = f"""
+{AUTO_SYNC_GENERATED}static _Thread_local uint32_t uiAutoSyncCombineSlot = UINT32_MAX;
+static atomic_uint uiAutoSyncCombineNextSlot;
+
+static uint32_t uiAutoSyncGetCombineSlot(void)
+{{
+  if (uiAutoSyncCombineSlot == UINT32_MAX) {{
+    uiAutoSyncCombineSlot = atomic_fetch_add_explicit(&uiAutoSyncCombineNextSlot, 1, memory_order_relaxed);
+  }}
+  return uiAutoSyncCombineSlot;
+}}
+"""
+    for shared_var, (var_type, mutex) in combined.items():
+        var_id = c_identifier(shared_var)
+        slots = f"xAutoSyncCombineSlots_{var_id}"
+        apply = f"xAutoSyncCombineApply_{var_id}"
+        code += f"""
+{AUTO_SYNC_GENERATED}static struct {{ _Alignas(AUTO_SYNC_CACHE_LINE_SIZE) atomic_uint uiPending; char cOp; {var_type} xOperand; {var_type} xResult; }} {slots}[AUTO_SYNC_MAX_THREADS];
+
+static {var_type} {apply}({var_type}* pxSharedVar, char cOp, {var_type} xOperand)
+{{
+  {var_type} xOld = *pxSharedVar;
+
+  switch (cOp) {{
+    case '+': *pxSharedVar = xOld + xOperand; break;
+    case '-': *pxSharedVar = xOld - xOperand; break;
+    case '|': *pxSharedVar = xOld | xOperand; break;
+    case '&': *pxSharedVar = xOld & xOperand; break;
+    case '^': *pxSharedVar = xOld ^ xOperand; break;
+  }}
+  return xOld;
+}}
+
+{var_type} xAutoSyncCombine_{var_id}({var_type}* pxSharedVar, char cOp, {var_type} xOperand)
+{{
+  uint32_t uiSlot = uiAutoSyncGetCombineSlot();
+  uint32_t uiSpin = 0;
+  {var_type} xOld;
+
+  if (uiSlot >= AUTO_SYNC_MAX_THREADS) {{
+    {sync_backend.lock(f"&{mutex}")};
+    xOld = {apply}(pxSharedVar, cOp, xOperand);
+    {sync_backend.unlock(f"&{mutex}")};
+    return xOld;
+  }}
+
+  {slots}[uiSlot].cOp = cOp;
+  {slots}[uiSlot].xOperand = xOperand;
+  atomic_store_explicit(&{slots}[uiSlot].uiPending, 1, memory_order_release);
+  for (;;) {{
+    if ({sync_backend.try_lock(f"&{mutex}")} == 0) {{
+      /* The thread with the mutex serves every posted operation, its own included */
+      uint32_t uiNoOfSlots = atomic_load_explicit(&uiAutoSyncCombineNextSlot, memory_order_relaxed);
+      if (uiNoOfSlots > AUTO_SYNC_MAX_THREADS) {{
+        uiNoOfSlots = AUTO_SYNC_MAX_THREADS;
+      }}
+      for (uint32_t i = 0; i < uiNoOfSlots; i++) {{
+        if (atomic_load_explicit(&{slots}[i].uiPending, memory_order_acquire)) {{
+          {slots}[i].xResult = {apply}(pxSharedVar, {slots}[i].cOp, {slots}[i].xOperand);
+          atomic_store_explicit(&{slots}[i].uiPending, 0, memory_order_release);
+        }}
+      }}
+      {sync_backend.unlock(f"&{mutex}")};
+    }}
+    if (!atomic_load_explicit(&{slots}[uiSlot].uiPending, memory_order_acquire)) {{
+      return {slots}[uiSlot].xResult;
+    }}
+    vAutoSyncSpinPause(&uiSpin);
+  }}
+}}
+"""
+    return code
+
+
+def get_barrier_events(event_sync_mechanisms: dict) -> dict:
+    '''
+    Get the events that do not use the default barrier (mutex and condition variable) or the barrier of OpenMP
+    '''
+    return {event: sync_mech for event, sync_mech in event_sync_mechanisms.items() \
+            if sync_mech[4] not in [AUTO_SYNC_BARRIER_DEFAULT, AUTO_SYNC_BARRIER_OMP]}
+
+
+def create_auto_sync_barriers(barrier_events: dict) -> str:
+    '''
+    Create the barrier functions of the events that selected a scalable barrier algorithm.
+    Threads wait on their own flags (dissemination) or on one release word (sense-reversing and tree),
+    first spinning and then sleeping on a futex, so no mutex is taken when proceeding on the event.
+    '''
+    if not barrier_events:
+        return ""
+
+    code = f"""
+{AUTO_SYNC_GENERATED}static void vAutoSyncFutexWait(atomic_uint* puiWord, atomic_uint* puiWaiters, uint32_t uiExpected)
+{{
+  uint32_t uiSpin;
+  uint32_t uiValue;
+
+  for (uiSpin = 0; uiSpin < AUTO_SYNC_SPIN_COUNT; uiSpin++) {{
+    if (atomic_load_explicit(puiWord, memory_order_acquire) == uiExpected) {{
+      return;
+    }}
+  }}
+
+  /* Sequentially consistent so that the waker either sees the waiter or the waiter sees the new value */
+  atomic_fetch_add(puiWaiters, 1);
+  while ((uiValue = atomic_load(puiWord)) != uiExpected) {{
+#ifdef __linux__
+    syscall(SYS_futex, puiWord, FUTEX_WAIT_PRIVATE, uiValue, NULL, NULL, 0);
+#else
+    sched_yield();
+#endif
+  }}
+  atomic_fetch_sub(puiWaiters, 1);
+}}
+
+static void vAutoSyncFutexWake(atomic_uint* puiWord, atomic_uint* puiWaiters)
+{{
+#ifdef __linux__
+  if (atomic_load(puiWaiters) > 0) {{
+    syscall(SYS_futex, puiWord, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+  }}
+#endif
+}}
+"""
+
+    for event, sync_mech in barrier_events.items():
+        barrier = sync_mech[4]
+        signature = f"int8_t iAutoSyncProceedOnEvent_{event}(uint32_t uiNoOfThreads)"
+
+        if barrier == AUTO_SYNC_BARRIER_SENSE_REVERSING:
+            code += f"""
+static atomic_uint uiAutoSyncCount_{event};
+static atomic_uint uiAutoSyncSense_{event};
+static atomic_uint uiAutoSyncWaiters_{event};
+
+{signature}
+{{
+  /* The episode cannot be released before this thread arrives, so the sense is still the one of the last episode.
+     Threads created after an episode wait for the right sense too */
+  uint32_t uiSense = !atomic_load_explicit(&uiAutoSyncSense_{event}, memory_order_acquire);
+
+  if (atomic_fetch_add_explicit(&uiAutoSyncCount_{event}, 1, memory_order_acq_rel) == uiNoOfThreads - 1) {{
+    /* Last thread: reset the counter and release the others */
+    atomic_store_explicit(&uiAutoSyncCount_{event}, 0, memory_order_relaxed);
+    atomic_store(&uiAutoSyncSense_{event}, uiSense);
+    vAutoSyncFutexWake(&uiAutoSyncSense_{event}, &uiAutoSyncWaiters_{event});
+  }} else {{
+    vAutoSyncFutexWait(&uiAutoSyncSense_{event}, &uiAutoSyncWaiters_{event}, uiSense);
+  }}
+
+  return AUTO_SYNC_OK;
+}}
+"""
+        elif barrier == AUTO_SYNC_BARRIER_DISSEMINATION:
+            code += f"""
+static struct {{ _Alignas(AUTO_SYNC_CACHE_LINE_SIZE) atomic_uint uiFlag[2][AUTO_SYNC_MAX_ROUNDS]; }} xAutoSyncFlags_{event}[AUTO_SYNC_MAX_THREADS];
+static atomic_ullong uiAutoSyncTicket_{event};
+
+{signature}
+{{
+  /* The threads of an episode draw consecutive tickets, no thread draws one of the next episode before all of
+     them arrived. The id is the position of the thread in its episode */
+  uint64_t uiTicket = atomic_fetch_add_explicit(&uiAutoSyncTicket_{event}, 1, memory_order_relaxed);
+  uint64_t uiEpisode = uiTicket / uiNoOfThreads;
+  uint32_t uiId = uiTicket % uiNoOfThreads;
+  /* Flags alternate between two sets, the sense flips every second episode */
+  uint32_t uiParity = uiEpisode & 1;
+  uint32_t uiSense = !((uiEpisode >> 1) & 1);
+  uint32_t uiRound;
+  uint32_t uiDistance;
+  uint32_t uiSpin = 0;
+
+  assert(uiNoOfThreads <= AUTO_SYNC_MAX_THREADS && uiId < uiNoOfThreads);
+
+  /* In round r, signal thread (id + 2^r) and wait for the signal of thread (id - 2^r) */
+  for (uiRound = 0, uiDistance = 1; uiDistance < uiNoOfThreads; uiRound++, uiDistance <<= 1) {{
+    uint32_t uiPartner = (uiId + uiDistance) % uiNoOfThreads;
+
+    atomic_store_explicit(&xAutoSyncFlags_{event}[uiPartner].uiFlag[uiParity][uiRound], uiSense, memory_order_release);
+    /* The flags are only set by other threads, no futex is needed */
+    while (atomic_load_explicit(&xAutoSyncFlags_{event}[uiId].uiFlag[uiParity][uiRound], memory_order_acquire) != uiSense) {{
+      vAutoSyncSpinPause(&uiSpin);
+    }}
+  }}
+
+  return AUTO_SYNC_OK;
+}}
+"""
+        elif barrier == AUTO_SYNC_BARRIER_TREE:
+            code += f"""
+static struct {{ _Alignas(AUTO_SYNC_CACHE_LINE_SIZE) atomic_uint uiCount; }} xAutoSyncNodes_{event}[AUTO_SYNC_MAX_THREADS];
+static atomic_ullong uiAutoSyncTicket_{event};
+static atomic_uint uiAutoSyncSense_{event};
+static atomic_uint uiAutoSyncWaiters_{event};
+
+{signature}
+{{
+  /* The id is the position of the thread in its episode, the sense flips every episode */
+  uint64_t uiTicket = atomic_fetch_add_explicit(&uiAutoSyncTicket_{event}, 1, memory_order_relaxed);
+  uint32_t uiId = uiTicket % uiNoOfThreads;
+  uint32_t uiSense = !((uiTicket / uiNoOfThreads) & 1);
+  uint32_t uiLevel;
+
+  assert(uiNoOfThreads <= AUTO_SYNC_MAX_THREADS && uiId < uiNoOfThreads);
+
+  /* Only two threads meet at each node. The first one waits, the second one goes up */
+  for (uiLevel = 0; (1u << uiLevel) < uiNoOfThreads; uiLevel++) {{
+    uint32_t uiGroup = uiId >> (uiLevel + 1);
+    uint32_t uiNode = AUTO_SYNC_MAX_THREADS - (AUTO_SYNC_MAX_THREADS >> uiLevel) + uiGroup;
+
+    if ((uiGroup << (uiLevel + 1)) + (1u << uiLevel) >= uiNoOfThreads) {{
+      /* Node has a single child */
+      continue;
+    }}
+
+    if (atomic_fetch_add_explicit(&xAutoSyncNodes_{event}[uiNode].uiCount, 1, memory_order_acq_rel) == 0) {{
+      vAutoSyncFutexWait(&uiAutoSyncSense_{event}, &uiAutoSyncWaiters_{event}, uiSense);
+      return AUTO_SYNC_OK;
+    }}
+    atomic_store_explicit(&xAutoSyncNodes_{event}[uiNode].uiCount, 0, memory_order_relaxed);
+  }}
+
+  /* Root of the tree: all threads arrived */
+  atomic_store(&uiAutoSyncSense_{event}, uiSense);
+  vAutoSyncFutexWake(&uiAutoSyncSense_{event}, &uiAutoSyncWaiters_{event});
+
+  return AUTO_SYNC_OK;
+}}
+"""
+        else:
+            print(f'[CODE GENERATOR ERROR] Unknown barrier {barrier} for event {event}')
+            exit(1)
+
+    return code
+
+
+def create_auto_sync_create(events_mutexes: list, events_cond_var: list, mutexes: dict, reductions: dict, sliced_arrays: dict, rwlocks: dict, mutex_types: dict) -> str:    
     SIGNATURE = "\nint8_t iAutoSyncCreate(void) \n{\n"
-    INIT_ATTR_MUTEX = "  pthread_mutexattr_init(&xMutexAttr);\n"
-    SET_ATTR_MUTEX = "  pthread_mutexattr_settype(&xMutexAttr, PTHREAD_MUTEX_RECURSIVE);\n\n"
 
-    # Init mutexes
     func_body = SIGNATURE
-    func_body += INIT_ATTR_MUTEX
-    func_body += SET_ATTR_MUTEX
+    func_body += sync_backend.init_attrs()
+
+    # Init mutexes, they are recursive unless the generator proved that they are never locked twice by a thread
     unique_mutexes = del_duplicates(mutexes.values())
     unique_mutexes += del_duplicates(events_mutexes)
     for mutex in unique_mutexes:
-        func_body += f"  assert(pthread_mutex_init(&{mutex}, &xMutexAttr) == 0);\n"
+        func_body += f"  {sync_backend.init_mutex(f'&{mutex}', mutex_types.get(mutex, MUTEX_RECURSIVE))}\n"
+    for stripes, no_of_stripes, first_access in get_striped_arrays(sliced_arrays).values():
+        func_body += f"  for (uint32_t uiStripe = 0; uiStripe < {no_of_stripes}; uiStripe++) {{\n"
+        func_body += f"    {sync_backend.init_mutex(f'&{stripes}[uiStripe].xMutex', mutex_types.get(stripes, MUTEX_RECURSIVE))}\n"
+        func_body += "  }\n"
+
+    # Init reader-writer locks, writers are preferred so that the rare writes are not starved by the readers
+    unique_rwlocks = del_duplicates(rwlocks.values())
+    if RWLOCK in [rwlock_type for rwlock, rwlock_type in unique_rwlocks]:
+        func_body += "\n  pthread_rwlockattr_init(&xRWLockAttr);\n"
+        func_body += "#ifdef __GLIBC__\n"
+        func_body += "  pthread_rwlockattr_setkind_np(&xRWLockAttr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);\n"
+        func_body += "#endif\n"
+    for rwlock, rwlock_type in unique_rwlocks:
+        if rwlock_type == RWLOCK:
+            func_body += f"  assert(pthread_rwlock_init(&{rwlock}, &xRWLockAttr) == 0);\n"
+        else:
+            func_body += f"  atomic_init(&{rwlock}.uiState, 0);\n"
 
     # Init condition variables
     func_body += "\n"
     for cond_var in events_cond_var:
-        func_body += f'  assert(pthread_cond_init(&{cond_var}, NULL) == 0);\n'
+        func_body += f'  {sync_backend.init_cond(f"&{cond_var}")}\n'
+
+    # Flush the reductions of the threads at thread exit
+    if get_typed_reductions(reductions):
+        func_body += "\n  assert(pthread_key_create(&xAutoSyncThreadExitKey, vAutoSyncThreadExit) == 0);\n"
     
     func_body += "\n  return 0; \n}\n"
 
     return func_body
 
-def create_auto_sync_destroy(events_mutexes: list, events_cond_var: list, mutexes: dict) -> str:    
+def create_auto_sync_destroy(events_mutexes: list, events_cond_var: list, mutexes: dict, reductions: dict, sliced_arrays: dict, rwlocks: dict, profile: bool) -> str:    
     SIGNATURE = "\nint8_t iAutoSyncDestroy(void) \n{\n"
 
-    # Destroy mutexes
     func_body = SIGNATURE
+
+    # The calling thread does not exit, so its reductions are flushed here
+    if get_typed_reductions(reductions):
+        func_body += "  if (uiAutoSyncSlot != UINT32_MAX) {\n"
+        func_body += "    vAutoSyncThreadExit((void*)((uintptr_t)uiAutoSyncSlot + 1));\n"
+        func_body += "  }\n"
+        func_body += "  assert(pthread_key_delete(xAutoSyncThreadExitKey) == 0);\n\n"
+
+    if profile:
+        func_body += "  vAutoSyncProfileDump();\n\n"
+
+    # Destroy mutexes
     unique_mutexes = del_duplicates(mutexes.values())
     unique_mutexes += del_duplicates(events_mutexes)
-    for mutex in unique_mutexes:
-        func_body += f"  assert(pthread_mutex_destroy(&{mutex}) == 0);\n"
+    # The mutexes of the futex backend do not hold any resource
+    if sync_backend.destroy_mutex(""):
+        for mutex in unique_mutexes:
+            func_body += f"  {sync_backend.destroy_mutex(f'&{mutex}')}\n"
+        for stripes, no_of_stripes, first_access in get_striped_arrays(sliced_arrays).values():
+            func_body += f"  for (uint32_t uiStripe = 0; uiStripe < {no_of_stripes}; uiStripe++) {{\n"
+            func_body += f"    {sync_backend.destroy_mutex(f'&{stripes}[uiStripe].xMutex')}\n"
+            func_body += "  }\n"
+    for rwlock, rwlock_type in del_duplicates(rwlocks.values()):
+        if rwlock_type == RWLOCK:
+            func_body += f"  assert(pthread_rwlock_destroy(&{rwlock}) == 0);\n"
 
     # Destroy condition variables
     func_body += "\n"
     for cond_var in events_cond_var:
-        func_body += f'  assert(pthread_cond_destroy(&{cond_var}) == 0);\n'
+        func_body += f'  {sync_backend.destroy_cond(f"&{cond_var}")}\n'
 
     func_body += "\n  return 0; \n}\n"
 
     return func_body
 
 
-def create_auto_sync_header(events_counter_var: list, events_mutexes: list, events_cond_var: list, auto_sync_unique_calls: list, mutexes: dict):
+def create_auto_sync_header(events_counter_var: list, events_mutexes: list, events_cond_var: list, auto_sync_unique_calls: list, mutexes: dict, atomic_vars: dict, reductions: dict, reduce_events: dict, event_sync_mechanisms: dict, sliced_arrays: dict, rwlocks: dict, seqlocks: dict, queues: dict, combined: dict, colocated: dict, layout: str, profile_sites: list, max_threads: int):
     with open("../00_AutoSync/AutoSync.h", "r") as header, open("../05_Workspace/_AutoSync.h", "w") as new_header:
         AUTO_SYNC_READ_SIGNATURE  = "int8_t iAutoSyncRead(void* pvValue, void* pvSharedVar, size_t xSizeData);\n"
         AUTO_SYNC_WRITE_SIGNATURE = "int8_t iAutoSyncWrite(void* pvSharedVar, void* pvValue, size_t xSizeData);\n"
@@ -283,11 +1825,35 @@ def create_auto_sync_header(events_counter_var: list, events_mutexes: list, even
             if AUTO_SYNC_READ_SIGNATURE in line or AUTO_SYNC_WRITE_SIGNATURE in line or \
                AUTO_SYNC_READ_TO_UPDATE_SIGNATURE in line or AUTO_SYNC_UPDATE_SIGNATURE in line :
                 pass
+            elif max_threads is not None and line.startswith("#define AUTO_SYNC_MAX_THREADS "):
+                new_header.write(f"#define AUTO_SYNC_MAX_THREADS {max_threads} /* Quantity of threads found by the parser */\n")
+            elif max_threads is not None and line.startswith("#define AUTO_SYNC_MAX_ROUNDS "):
+                new_header.write(f"#define AUTO_SYNC_MAX_ROUNDS {max_threads.bit_length() - 1} /* log2(AUTO_SYNC_MAX_THREADS) */\n")
             elif "#endif" not in line:
                 new_header.write(line)
+
+            spin_rwlocks = SPIN_RWLOCK in [rwlock_type for rwlock, rwlock_type in rwlocks.values()]
+            # Every spinning wait pauses with vAutoSyncSpinPause
+            spin_waits = spin_rwlocks or seqlocks or queues or combined or AUTO_SYNC_BARRIER_DISSEMINATION in \
+                         [sync_mech[4] for sync_mech in get_barrier_events(event_sync_mechanisms).values()]
+            if "#include <stdint.h>" in line and (atomic_vars or spin_rwlocks or seqlocks or sync_backend is SYNC_BACKENDS[BACKEND_FUTEX]):
+                new_header.write("#include <stdatomic.h>\n")
+            if "#include <stdint.h>" in line and spin_waits:
+                new_header.write("#include <sched.h>\n")
+            if "#include <stdint.h>" in line and profile_sites is not None:
+                new_header.write("#include <time.h>\n")
             
             if "/* EXTERNAL VARIABLES */" in line:
-                new_header.write(decl_mutexes(mutexes, events_mutexes))
+                if spin_waits:
+                    new_header.write(create_auto_sync_spin_pause())
+                if spin_rwlocks:
+                    new_header.write(create_auto_sync_spin_rwlock())
+                if seqlocks:
+                    new_header.write(create_auto_sync_seqlock())
+                if profile_sites is not None:
+                    new_header.write(create_auto_sync_profiler(profile_sites))
+                new_header.write(sync_backend.create_header())
+                new_header.write(decl_mutexes(mutexes, events_mutexes, sliced_arrays, rwlocks, seqlocks, colocated, layout))
                 new_header.write("\n\n")
                 new_header.write(decl_cond_var(events_cond_var))
                 new_header.write("\n\n")
@@ -306,127 +1872,1904 @@ def create_auto_sync_header(events_counter_var: list, events_mutexes: list, even
             #    new_header.write(re.sub(func_sig, new_func_call, AUTO_SYNC_READ_TO_UPDATE_SIGNATURE))
             #if AUTO_SYNC_UPDATE == func_sig:
             #    new_header.write(re.sub(func_sig, new_func_call, AUTO_SYNC_UPDATE_SIGNATURE))
+
+        for shared_var in get_typed_reductions(reductions):
+            new_header.write(f"int8_t iAutoSyncReduce_{c_identifier(shared_var)}(void* pvSharedVar, void* pvValue);\n")
+        for event, shared_vars in sorted(reduce_events.items()):
+            for shared_var in shared_vars:
+                new_header.write(f"int8_t iAutoSyncReduceCombine_{event}_{c_identifier(shared_var)}(uint32_t uiNoOfThreads);\n")
+        if get_typed_reductions(reductions) and sync_backend.openmp:
+            new_header.write("void vAutoSyncReduceFlushThread(void);\n")
+
+        for event in get_barrier_events(event_sync_mechanisms):
+            new_header.write(f"int8_t iAutoSyncProceedOnEvent_{event}(uint32_t uiNoOfThreads);\n")
+
+        for queue in queues:
+            new_header.write(f"int8_t {AUTO_SYNC_ENQUEUE}_{c_identifier(queue)}(void* pvQueue, void* pvItem, size_t xSizeData);\n")
+            new_header.write(f"int8_t {AUTO_SYNC_DEQUEUE}_{c_identifier(queue)}(void* pvItem, void* pvQueue, size_t xSizeData);\n")
+
+        for shared_var, (var_type, mutex) in combined.items():
+            new_header.write(f"{var_type} xAutoSyncCombine_{c_identifier(shared_var)}({var_type}* pxSharedVar, char cOp, {var_type} xOperand);\n")
         new_header.write("#endif\n")
 
 
-def replace_auto_sync_calls(path: str, auto_sync_calls: dict, mutexes: dict, intentions: dict, event_sync_mechanisms: dict):
-    # Replace calls to the interface in the original file     
-    with open(path, "r+") as source, open("../05_Workspace/temp.c", "w") as tmp:
-        for line_no, line in enumerate(source):            
-            line_no += 1     
-
-            if str(line_no) in auto_sync_calls.keys():  
-                func_sig = auto_sync_calls[str(line_no)][0]                 
-
-                if func_sig == AUTO_SYNC_READ_TO_UPDATE:     
-                    shared_var = auto_sync_calls[str(line_no)][1]              
-                    if not ("bConstantInitByMain" in intentions[shared_var]):
-                        # We only assign a lock if it is NOT a constant init by main
-                        tmp.write(f"{AUTO_SYNC_GENERATED}pthread_mutex_lock(&{mutexes[shared_var]});\n")
-
-                    memcpy = line.replace("iAutoSyncReadToUpdate", "memcpy")
-                    memcpy = re.sub(r"\,\s*\S*\)\;", ");", memcpy, 0, re.MULTILINE)
-                    tmp.write(memcpy)
-                elif func_sig == AUTO_SYNC_UPDATE:  
-                    shared_var = auto_sync_calls[str(line_no)][1]                  
-                    memcpy = line.replace("iAutoSyncUpdate", "memcpy")
-                    memcpy = re.sub(r"\,\s*\S*\)\;", ");", memcpy, 0, re.MULTILINE)
-                    tmp.write(memcpy)
-
-                    if not ("bConstantInitByMain" in intentions[shared_var]):
-                        # We only assign a lock if it is NOT a constant init by main
-                        tmp.write(f"{AUTO_SYNC_GENERATED}pthread_mutex_unlock(&{mutexes[shared_var]});\n") 
-                elif func_sig == AUTO_SYNC_READ:
-                    shared_var = auto_sync_calls[str(line_no)][1]
-                    if not ("bConstantInitByMain" in intentions[shared_var]):
-                        # We on     ly assign a lock if it is NOT a constant init by main
-                        tmp.write(f"{AUTO_SYNC_GENERATED}pthread_mutex_lock(&{mutexes[shared_var]});\n")
-
-                    memcpy = line.replace("iAutoSyncRead", "memcpy")
-                    memcpy = re.sub(r"\,\s*\S*\)\;", ");", memcpy, 0, re.MULTILINE)
-                    tmp.write(memcpy)
-
-                    if not ("bConstantInitByMain" in intentions[shared_var]):
-                        # We only assign a lock if it is NOT a constant init by main
-                        tmp.write(f"{AUTO_SYNC_GENERATED}pthread_mutex_unlock(&{mutexes[shared_var]});\n")
-                elif func_sig == AUTO_SYNC_WRITE:      
-                    shared_var = auto_sync_calls[str(line_no)][1]
-
-                    if not ("bConstantInitByMain" in intentions[shared_var]):
-                        # We only assign a lock if it is NOT a constant init by main
-                        tmp.write(f"{AUTO_SYNC_GENERATED}pthread_mutex_lock(&{mutexes[shared_var]});\n")
-
-                    memcpy = line.replace("iAutoSyncWrite", "memcpy")
-                    memcpy = re.sub(r"\,\s*\S*\)\;", ");", memcpy, 0, re.MULTILINE)
-                    tmp.write(memcpy)
-
-                    if not ("bConstantInitByMain" in intentions[shared_var]):
-                        # We only assign a lock if it is NOT a constant init by main
-                        tmp.write(f"{AUTO_SYNC_GENERATED}pthread_mutex_unlock(&{mutexes[shared_var]});\n") 
-                elif func_sig == AUTO_SYNC_PROCEED_ON_EVENT:
-                    #embed()         
-                    event = auto_sync_calls[str(line_no)][1]
-                    event_mutex = event_sync_mechanisms[event][0]
-                    event_cond_var = event_sync_mechanisms[event][1]
-                    event_counter_var = event_sync_mechanisms[event][2]
-                    event_no_of_threads = auto_sync_calls[str(line_no)][2] 
-                    
-                    barrier_body = f'pthread_mutex_lock(&{event_mutex});\n \
+def create_auto_sync_spin_pause() -> str:
+    return f"""{AUTO_SYNC_GENERATED}static inline void vAutoSyncSpinPause(uint32_t* puiSpin)
+{{
+  if (++(*puiSpin) >= AUTO_SYNC_SPIN_COUNT) {{
+    /* Let other threads run when there are more threads than cores */
+    sched_yield();
+    *puiSpin = 0;
+  }}
+}}
+
+"""
+
+
+def create_auto_sync_spin_rwlock() -> str:
+    '''
+    Create a writer-preferring reader-writer spin lock for short critical sections.
+    The state holds the quantity of readers, a flag for the writer holding the lock and a flag for waiting writers.
+    New readers wait while a writer is waiting, so the writers are not starved.
+    The functions are inline because the critical sections are only a copy of the shared-variable.
+    '''
+    return f"""{AUTO_SYNC_GENERATED}#define AUTO_SYNC_RW_WRITER  0x80000000u
+#define AUTO_SYNC_RW_WAITING 0x40000000u
+
+typedef struct xAutoSyncSpinRWLockStruct
+{{
+  _Alignas(AUTO_SYNC_CACHE_LINE_SIZE) atomic_uint uiState;
+}} xAutoSyncSpinRWLock;
+
+static inline void vAutoSyncSpinReadLock(xAutoSyncSpinRWLock* pxLock)
+{{
+  uint32_t uiSpin = 0;
+  uint32_t uiState = atomic_load_explicit(&pxLock->uiState, memory_order_relaxed);
+
+  for (;;) {{
+    if (!(uiState & (AUTO_SYNC_RW_WRITER | AUTO_SYNC_RW_WAITING))) {{
+      if (atomic_compare_exchange_weak_explicit(&pxLock->uiState, &uiState, uiState + 1,
+                                                memory_order_acquire, memory_order_relaxed)) {{
+        return;
+      }}
+    }}
+    else {{
+      vAutoSyncSpinPause(&uiSpin);
+      uiState = atomic_load_explicit(&pxLock->uiState, memory_order_relaxed);
+    }}
+  }}
+}}
+
+static inline void vAutoSyncSpinReadUnlock(xAutoSyncSpinRWLock* pxLock)
+{{
+  atomic_fetch_sub_explicit(&pxLock->uiState, 1, memory_order_release);
+}}
+
+static inline void vAutoSyncSpinWriteLock(xAutoSyncSpinRWLock* pxLock)
+{{
+  uint32_t uiSpin = 0;
+  uint32_t uiState = atomic_load_explicit(&pxLock->uiState, memory_order_relaxed);
+
+  for (;;) {{
+    if (!(uiState & ~AUTO_SYNC_RW_WAITING)) {{
+      /* No reader and no writer, clearing the waiting flag lets the other waiting writers set it again */
+      if (atomic_compare_exchange_weak_explicit(&pxLock->uiState, &uiState, AUTO_SYNC_RW_WRITER,
+                                                memory_order_acquire, memory_order_relaxed)) {{
+        return;
+      }}
+    }}
+    else {{
+      if (!(uiState & AUTO_SYNC_RW_WAITING)) {{
+        atomic_fetch_or_explicit(&pxLock->uiState, AUTO_SYNC_RW_WAITING, memory_order_relaxed);
+      }}
+      vAutoSyncSpinPause(&uiSpin);
+      uiState = atomic_load_explicit(&pxLock->uiState, memory_order_relaxed);
+    }}
+  }}
+}}
+
+static inline void vAutoSyncSpinWriteUnlock(xAutoSyncSpinRWLock* pxLock)
+{{
+  atomic_fetch_and_explicit(&pxLock->uiState, ~AUTO_SYNC_RW_WRITER, memory_order_release);
+}}
+
+/* Like pthread_rwlock_tryrdlock/trywrlock, 0 if the lock was taken */
+static inline int iAutoSyncSpinTryReadLock(xAutoSyncSpinRWLock* pxLock)
+{{
+  uint32_t uiState = atomic_load_explicit(&pxLock->uiState, memory_order_relaxed);
+  return (uiState & (AUTO_SYNC_RW_WRITER | AUTO_SYNC_RW_WAITING)) ||
+         !atomic_compare_exchange_strong_explicit(&pxLock->uiState, &uiState, uiState + 1,
+                                                  memory_order_acquire, memory_order_relaxed);
+}}
+
+static inline int iAutoSyncSpinTryWriteLock(xAutoSyncSpinRWLock* pxLock)
+{{
+  uint32_t uiState = atomic_load_explicit(&pxLock->uiState, memory_order_relaxed);
+  return (uiState & ~AUTO_SYNC_RW_WAITING) ||
+         !atomic_compare_exchange_strong_explicit(&pxLock->uiState, &uiState, AUTO_SYNC_RW_WRITER,
+                                                  memory_order_acquire, memory_order_relaxed);
+}}
+
+"""
+
+
+def create_auto_sync_seqlock() -> str:
+    '''
+    Create the sequence lock functions for the optimistic reads.
+    Writers are still serialized by the lock of the shared-variable and make the sequence odd while they copy.
+    Readers copy without writing to a shared cache line and retry if the sequence was odd or has changed.
+    '''
+    return f"""{AUTO_SYNC_GENERATED}static inline uint32_t uiAutoSyncSeqReadBegin(atomic_uint* puiSeq)
+{{
+  uint32_t uiSpin = 0;
+  uint32_t uiSeq;
+
+  while ((uiSeq = atomic_load_explicit(puiSeq, memory_order_acquire)) & 1) {{
+    vAutoSyncSpinPause(&uiSpin);
+  }}
+  return uiSeq;
+}}
+
+static inline bool bAutoSyncSeqReadRetry(atomic_uint* puiSeq, uint32_t uiSeq)
+{{
+  /* The copy must be completed before the sequence is checked again */
+  atomic_thread_fence(memory_order_acquire);
+  return atomic_load_explicit(puiSeq, memory_order_relaxed) != uiSeq;
+}}
+
+static inline void vAutoSyncSeqWriteBegin(atomic_uint* puiSeq)
+{{
+  atomic_store_explicit(puiSeq, atomic_load_explicit(puiSeq, memory_order_relaxed) + 1, memory_order_relaxed);
+  /* The odd sequence must be visible before the copy */
+  atomic_thread_fence(memory_order_release);
+}}
+
+static inline void vAutoSyncSeqWriteEnd(atomic_uint* puiSeq)
+{{
+  atomic_store_explicit(puiSeq, atomic_load_explicit(puiSeq, memory_order_relaxed) + 1, memory_order_release);
+}}
+
+"""
+
+
+def create_auto_sync_profiler(profile_sites: list) -> str:
+    '''
+    Create the counters of the lock profiler. Every thread counts in its own block of counters, one per lock site,
+    so the profiled locks do not share any cache line. The blocks are combined by iAutoSyncDestroy.
+    The time a thread waits for a lock is counted from the first try until it has the lock, the time it holds
+    the lock until it unlocks it.
+    '''
+    return f"""{AUTO_SYNC_GENERATED}#define AUTO_SYNC_PROFILE_SITES {max(len(profile_sites), 1)}
+#define AUTO_SYNC_PROFILE_PATH "auto_sync_profile.json" /* Overwritten by the environment variable AUTO_SYNC_PROFILE */
+
+typedef struct xAutoSyncProfileSiteStruct
+{{
+  uint64_t ullAcquisitions;
+  uint64_t ullContended;
+  uint64_t ullWaitNs;
+  uint64_t ullHoldNs;
+  uint64_t ullHoldStart;
+}} xAutoSyncProfileSite;
+
+typedef struct xAutoSyncProfileStruct
+{{
+  xAutoSyncProfileSite xSites[AUTO_SYNC_PROFILE_SITES];
+  struct xAutoSyncProfileStruct* pxNext;
+}} xAutoSyncProfile;
+
+extern _Thread_local xAutoSyncProfile* pxAutoSyncProfile;
+xAutoSyncProfile* pxAutoSyncProfileThread(void);
+
+static inline uint64_t ullAutoSyncProfileNow(void)
+{{
+  struct timespec xNow;
+  clock_gettime(CLOCK_MONOTONIC, &xNow);
+  return (uint64_t)xNow.tv_sec * 1000000000ull + (uint64_t)xNow.tv_nsec;
+}}
+
+static inline void vAutoSyncProfileLocked(uint32_t uiSite, uint64_t ullStart, bool bContended)
+{{
+  xAutoSyncProfileSite* pxSite = &(pxAutoSyncProfile ? pxAutoSyncProfile : pxAutoSyncProfileThread())->xSites[uiSite];
+  uint64_t ullNow = ullAutoSyncProfileNow();
+
+  pxSite->ullAcquisitions++;
+  pxSite->ullContended += bContended;
+  pxSite->ullWaitNs += ullNow - ullStart;
+  pxSite->ullHoldStart = ullNow;
+}}
+
+static inline void vAutoSyncProfileUnlock(uint32_t uiSite)
+{{
+  xAutoSyncProfileSite* pxSite = &(pxAutoSyncProfile ? pxAutoSyncProfile : pxAutoSyncProfileThread())->xSites[uiSite];
+  pxSite->ullHoldNs += ullAutoSyncProfileNow() - pxSite->ullHoldStart;
+}}
+
+#define AUTO_SYNC_PROFILE_BEGIN() uint64_t ullAutoSyncStart = ullAutoSyncProfileNow(); bool bAutoSyncContended = false
+#define AUTO_SYNC_PROFILE_TRY_LOCK(xTryLock, xLock) if ((xTryLock) != 0) {{ bAutoSyncContended = true; xLock; }}
+#define AUTO_SYNC_PROFILE_END(uiSite) vAutoSyncProfileLocked(uiSite, ullAutoSyncStart, bAutoSyncContended)
+
+"""
+
+
+def create_auto_sync_profile_dump(profile_sites: list) -> str:
+    '''
+    Create the registration of the counters of every thread and the dump of the lock profile.
+    The profile is a JSON object with the shared-variables (or events) as keys, every one has its lock sites
+    with the source line as key.
+    EXAMPLE:
+        {"Global->id": {"616": {"Lock": "xMutex_Global_id", "Acquisitions": 4, "Contended": 1, "WaitNs": 2110, "HoldNs": 380}}}
+    '''
+    # The sites are dumped grouped by shared-variable
+    order = sorted(range(len(profile_sites)), key=lambda site: (profile_sites[site][1], int(profile_sites[site][0])))
+    closing = "\\n  }" if profile_sites else ""
+    sites = ",\n".join(f'  {{"{shared_var}", "{line_no}", "{lock}"}}' for line_no, shared_var, lock in profile_sites)
+    func_body = f"""
+{AUTO_SYNC_GENERATED}_Thread_local xAutoSyncProfile* pxAutoSyncProfile = NULL;
+static xAutoSyncProfile* pxAutoSyncProfiles = NULL;
+static pthread_mutex_t xAutoSyncProfileMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Shared-variable or event, line and lock of every profiled site */
+static const char* const pcAutoSyncProfileSites[][3] = {{
+{sites if sites else '  {"", "", ""}'}
+}};
+static const uint32_t uiAutoSyncProfileOrder[AUTO_SYNC_PROFILE_SITES] = {{{", ".join(str(site) for site in order) if order else "0"}}};
+
+xAutoSyncProfile* pxAutoSyncProfileThread(void)
+{{
+  pxAutoSyncProfile = calloc(1, sizeof(xAutoSyncProfile));
+  assert(pxAutoSyncProfile != NULL);
+
+  /* The counters outlive the thread, they are only read by iAutoSyncDestroy */
+  pthread_mutex_lock(&xAutoSyncProfileMutex);
+  pxAutoSyncProfile->pxNext = pxAutoSyncProfiles;
+  pxAutoSyncProfiles = pxAutoSyncProfile;
+  pthread_mutex_unlock(&xAutoSyncProfileMutex);
+  return pxAutoSyncProfile;
+}}
+
+static void vAutoSyncProfileDump(void)
+{{
+  const char* pcPath = getenv("AUTO_SYNC_PROFILE") ? getenv("AUTO_SYNC_PROFILE") : AUTO_SYNC_PROFILE_PATH;
+  FILE* pxFile = fopen(pcPath, "w");
+  if (pxFile == NULL) {{
+    perror(pcPath);
+    return;
+  }}
+
+  fprintf(pxFile, "{{");
+  for (uint32_t uiIdx = 0; uiIdx < {len(profile_sites)}; uiIdx++) {{
+    uint32_t uiSite = uiAutoSyncProfileOrder[uiIdx];
+    xAutoSyncProfileSite xTotal = {{0}};
+    for (xAutoSyncProfile* pxProfile = pxAutoSyncProfiles; pxProfile != NULL; pxProfile = pxProfile->pxNext) {{
+      xTotal.ullAcquisitions += pxProfile->xSites[uiSite].ullAcquisitions;
+      xTotal.ullContended += pxProfile->xSites[uiSite].ullContended;
+      xTotal.ullWaitNs += pxProfile->xSites[uiSite].ullWaitNs;
+      xTotal.ullHoldNs += pxProfile->xSites[uiSite].ullHoldNs;
+    }}
+
+    bool bNewSharedVar = uiIdx == 0 || strcmp(pcAutoSyncProfileSites[uiSite][0], pcAutoSyncProfileSites[uiAutoSyncProfileOrder[uiIdx - 1]][0]) != 0;
+    if (bNewSharedVar) {{
+      fprintf(pxFile, "%s\\n  \\"%s\\": {{", uiIdx == 0 ? "" : "\\n  }},", pcAutoSyncProfileSites[uiSite][0]);
+    }}
+    fprintf(pxFile, "%s\\n    \\"%s\\": {{\\"Lock\\": \\"%s\\", \\"Acquisitions\\": %llu, \\"Contended\\": %llu, \\"WaitNs\\": %llu, \\"HoldNs\\": %llu}}",
+            bNewSharedVar ? "" : ",", pcAutoSyncProfileSites[uiSite][1], pcAutoSyncProfileSites[uiSite][2],
+            (unsigned long long)xTotal.ullAcquisitions, (unsigned long long)xTotal.ullContended,
+            (unsigned long long)xTotal.ullWaitNs, (unsigned long long)xTotal.ullHoldNs);
+  }}
+  fprintf(pxFile, "{closing}\\n}}\\n");
+  fclose(pxFile);
+
+  while (pxAutoSyncProfiles != NULL) {{
+    xAutoSyncProfile* pxNext = pxAutoSyncProfiles->pxNext;
+    free(pxAutoSyncProfiles);
+    pxAutoSyncProfiles = pxNext;
+  }}
+  pxAutoSyncProfile = NULL;
+}}
+"""
+    return func_body
+
+
+def lock_shared_var(shared_var: str, index: str, mutexes: dict, sliced_arrays: dict, rwlocks: dict, write: bool, profile_site: int = None) -> str:
+    '''
+    Generate the code that locks the mutex of a shared-variable.
+    Reader-writer locks are locked for reading or writing according to the access.
+    For striped arrays, the access to an element only locks the stripe of the element and the access
+    to the whole array locks all the stripes in ascending order.
+    With the OpenMP backend, the mutexes of critical_mutexes open a named critical region instead, closed by the unlock.
+    Returns an empty string if the shared-variable does not need a lock (disjoint slices).
+    EXAMPLE:
+        pthread_mutex_lock(&xMutexStripes_Global_transtimes[(uint64_t)(MyNum) % 64].xMutex);
+    '''
+    if shared_var in mutexes and mutexes[shared_var] in sync_backend.critical_mutexes:
+        return f"{AUTO_SYNC_GENERATED}#pragma omp critical({c_identifier(mutexes[shared_var])})\n{{\n"
+    if shared_var in mutexes:
+        mutex = f"&{mutexes[shared_var]}"
+        return lock_call(sync_backend.lock(mutex), sync_backend.try_lock(mutex), "", profile_site)
+    if shared_var in rwlocks:
+        rwlock, rwlock_type = rwlocks[shared_var]
+        if rwlock_type == RWLOCK:
+            mode = 'wrlock' if write else 'rdlock'
+            return lock_call(f"pthread_rwlock_{mode}(&{rwlock})", f"pthread_rwlock_try{mode}(&{rwlock})", "", profile_site)
+        mode = 'Write' if write else 'Read'
+        return lock_call(f"vAutoSyncSpin{mode}Lock(&{rwlock})", f"iAutoSyncSpinTry{mode}Lock(&{rwlock})", "", profile_site)
+
+    stripes, no_of_stripes, first_access = sliced_arrays[shared_var]
+    if not stripes:
+        return ""
+    if index:
+        mutex = f"&{stripes}[{get_stripe(index, no_of_stripes, first_access)}].xMutex"
+        return lock_call(sync_backend.lock(mutex), sync_backend.try_lock(mutex), "", profile_site)
+    mutex = f"&{stripes}[uiStripe].xMutex"
+    return lock_call(sync_backend.lock(mutex), sync_backend.try_lock(mutex),
+                     f"for (uint32_t uiStripe = 0; uiStripe < {no_of_stripes}; uiStripe++) ", profile_site)
+
+
+def lock_call(lock: str, try_lock: str, loop: str, profile_site: int) -> str:
+    '''
+    Generate the statement that takes a lock, repeated by the loop if there is one.
+    Profiled locks are tried first to count the contended acquisitions, the wait for the lock is timed.
+    EXAMPLE:
+        { AUTO_SYNC_PROFILE_BEGIN(); AUTO_SYNC_PROFILE_TRY_LOCK(pthread_mutex_trylock(&xMutex_N), pthread_mutex_lock(&xMutex_N)); AUTO_SYNC_PROFILE_END(3); }
+    '''
+    if profile_site is None:
+        return f"{AUTO_SYNC_GENERATED}{loop}{lock};\n"
+    return f"{AUTO_SYNC_GENERATED}{{ AUTO_SYNC_PROFILE_BEGIN(); " + \
+           f"{loop}AUTO_SYNC_PROFILE_TRY_LOCK({try_lock}, {lock}); " + \
+           f"AUTO_SYNC_PROFILE_END({profile_site}); }}\n"
+
+
+def get_lock_name(shared_var: str, mutexes: dict, sliced_arrays: dict, rwlocks: dict) -> str:
+    if shared_var in mutexes:
+        return mutexes[shared_var]
+    if shared_var in rwlocks:
+        return rwlocks[shared_var][0]
+    return sliced_arrays[shared_var][0]
+
+
+def unlock_shared_var(shared_var: str, index: str, mutexes: dict, sliced_arrays: dict, rwlocks: dict, write: bool) -> str:
+    '''
+    Generate the code that unlocks the mutex of a shared-variable. All the stripes are unlocked in reverse order.
+    Returns an empty string if the shared-variable does not need a lock (disjoint slices).
+    '''
+    if shared_var in mutexes and mutexes[shared_var] in sync_backend.critical_mutexes:
+        return f"{AUTO_SYNC_GENERATED}}}\n"
+    if shared_var in mutexes:
+        return f"{AUTO_SYNC_GENERATED}{sync_backend.unlock(f'&{mutexes[shared_var]}')};\n"
+    if shared_var in rwlocks:
+        rwlock, rwlock_type = rwlocks[shared_var]
+        if rwlock_type == RWLOCK:
+            return f"{AUTO_SYNC_GENERATED}pthread_rwlock_unlock(&{rwlock});\n"
+        return f"{AUTO_SYNC_GENERATED}vAutoSyncSpin{'Write' if write else 'Read'}Unlock(&{rwlock});\n"
+
+    stripes, no_of_stripes, first_access = sliced_arrays[shared_var]
+    if not stripes:
+        return ""
+    if index:
+        return f"{AUTO_SYNC_GENERATED}{sync_backend.unlock(f'&{stripes}[{get_stripe(index, no_of_stripes, first_access)}].xMutex')};\n"
+    return f"{AUTO_SYNC_GENERATED}for (uint32_t uiStripe = {no_of_stripes}; uiStripe-- > 0;) " + \
+           f"{sync_backend.unlock(f'&{stripes}[uiStripe].xMutex')};\n"
+
+
+def seqlock_write(shared_var: str, memcpy: str, seqlocks: dict) -> str:
+    '''
+    Surround the copy to a shared-variable with optimistic reads by the odd sequence of its sequence lock.
+    '''
+    if shared_var not in seqlocks:
+        return memcpy
+
+    indent = memcpy[:len(memcpy) - len(memcpy.lstrip())]
+    return f"{indent}{AUTO_SYNC_GENERATED}{indent}vAutoSyncSeqWriteBegin(&{seqlocks[shared_var]});\n" + \
+           memcpy + \
+           f"{indent}vAutoSyncSeqWriteEnd(&{seqlocks[shared_var]});\n"
+
+
+def get_stripe(index: str, no_of_stripes: int, first_access: int) -> str:
+    if first_access:
+        return f"(uint64_t)(({index}) - {first_access}) % {no_of_stripes}"
+    return f"(uint64_t)({index}) % {no_of_stripes}"
+
+
+def replace_auto_sync_calls(path: str, call_sites: dict, auto_sync_calls: dict, mutexes: dict, intentions: dict, event_sync_mechanisms: dict, atomic_sections: dict, reductions: dict, reduce_events: dict, sliced_arrays: dict, array_indexes: dict, rwlocks: dict, seqlocks: dict, colocated_decls: dict, elided_locks: set, elided_unlocks: set, loop_sections: dict, loop_edges: dict, thread_sections: dict, combine_sections: dict, profile: bool, outputs: dict):
+    # Replace calls to the interface in the original file
+    # Profiled lock sites: line, shared-variable (or event) and lock. The unlocks are matched with their lock sites
+    profile_sites = [] if profile else None
+    held_sites = dict()
+    generator = c_generator.CGenerator()
+
+    def lock(site: str, shared_var: str, write: bool) -> str:
+        code = lock_shared_var(shared_var, array_indexes[site], mutexes, sliced_arrays, rwlocks, write)
+        if not profile or not code:
+            return code
+        profile_sites.append((site, shared_var, get_lock_name(shared_var, mutexes, sliced_arrays, rwlocks)))
+        unlock_code = unlock_shared_var(shared_var, array_indexes[site], mutexes, sliced_arrays, rwlocks, write)
+        held_sites.setdefault(unlock_code, []).append(len(profile_sites) - 1)
+        return lock_shared_var(shared_var, array_indexes[site], mutexes, sliced_arrays, rwlocks, write, len(profile_sites) - 1)
+
+    def unlock(site: str, shared_var: str, write: bool) -> str:
+        code = unlock_shared_var(shared_var, array_indexes[site], mutexes, sliced_arrays, rwlocks, write)
+        if not held_sites.get(code):
+            return code
+        return code.replace(AUTO_SYNC_GENERATED, f"{AUTO_SYNC_GENERATED}vAutoSyncProfileUnlock({held_sites[code].pop()});\n", 1)
+
+    def rewrite_call(call_site: CallSite, indent: str) -> str:
+        # The copy of the call is generated from its AST, the last argument (the intention) is dropped
+        site = call_site.site
+        func_sig = call_site.func_sig
+        memcpy = indent + generator.visit(c_ast.FuncCall(c_ast.ID("memcpy"), c_ast.ExprList(call_site.node.args.exprs[:3]))) + ";\n"
+        code = ""
+
+        if func_sig == AUTO_SYNC_READ_TO_UPDATE:
+            shared_var = auto_sync_calls[site][1]
+            if not ("bConstantInitByMain" in intentions[shared_var]) and site not in elided_locks:
+                # We only assign a lock if it is NOT a constant init by main
+                code += lock(site, shared_var, True)
+            code += memcpy
+        elif func_sig == AUTO_SYNC_UPDATE:
+            shared_var = auto_sync_calls[site][1]
+            code += seqlock_write(shared_var, memcpy, seqlocks)
+
+            if not ("bConstantInitByMain" in intentions[shared_var]) and site not in elided_unlocks:
+                # We only assign a lock if it is NOT a constant init by main
+                code += unlock(site, shared_var, True)
+        elif func_sig == AUTO_SYNC_READ and auto_sync_calls[site][1] in seqlocks:
+            # Optimistic read, the copy is repeated if a writer was copying at the same time
+            shared_var = auto_sync_calls[site][1]
+            code += f"{indent}{AUTO_SYNC_GENERATED}"
+            code += f"{indent}{{\n"
+            code += f"{indent}  uint32_t uiAutoSyncSeq;\n"
+            code += f"{indent}  do {{\n"
+            code += f"{indent}    uiAutoSyncSeq = uiAutoSyncSeqReadBegin(&{seqlocks[shared_var]});\n"
+            code += f"    {memcpy}"
+            code += f"{indent}  }} while (bAutoSyncSeqReadRetry(&{seqlocks[shared_var]}, uiAutoSyncSeq));\n"
+            code += f"{indent}}}\n"
+        elif func_sig == AUTO_SYNC_READ:
+            shared_var = auto_sync_calls[site][1]
+            if not ("bConstantInitByMain" in intentions[shared_var]) and site not in elided_locks:
+                # We only assign a lock if it is NOT a constant init by main
+                code += lock(site, shared_var, False)
+            code += memcpy
+            if not ("bConstantInitByMain" in intentions[shared_var]) and site not in elided_unlocks:
+                # We only assign a lock if it is NOT a constant init by main
+                code += unlock(site, shared_var, False)
+        elif func_sig == AUTO_SYNC_WRITE:
+            shared_var = auto_sync_calls[site][1]
+            if not ("bConstantInitByMain" in intentions[shared_var]) and site not in elided_locks:
+                # We only assign a lock if it is NOT a constant init by main
+                code += lock(site, shared_var, True)
+            code += seqlock_write(shared_var, memcpy, seqlocks)
+            if not ("bConstantInitByMain" in intentions[shared_var]) and site not in elided_unlocks:
+                # We only assign a lock if it is NOT a constant init by main
+                code += unlock(site, shared_var, True)
+        elif func_sig == AUTO_SYNC_REDUCE:
+            shared_var = auto_sync_calls[site][1]
+            var_type, reduce_op = reductions[shared_var]
+            args = call_site.get_args()
+
+            code += f"{indent}{AUTO_SYNC_GENERATED}"
+            if var_type:
+                # Accumulate in the slot of the thread, it is combined at the next event or at thread exit
+                code += f"{indent}iAutoSyncReduce_{c_identifier(shared_var)}({args[0]}, {args[1]});\n"
+            else:
+                # Type is unknown, combine directly
+                reduced = REDUCE_OPS[reduce_op].format(a=f"({deref_arg(args[0])})", b=f"({deref_arg(args[1])})")
+                code += f"{indent}{sync_backend.lock(f'&{mutexes[shared_var]}')};\n"
+                code += f"{indent}{deref_arg(args[0])} = {reduced};\n"
+                code += f"{indent}{sync_backend.unlock(f'&{mutexes[shared_var]}')};\n"
+        elif func_sig in [AUTO_SYNC_ENQUEUE, AUTO_SYNC_DEQUEUE]:
+            # The ring buffer of the queue is generated in _AutoSync.c, the intention is dropped
+            queue = auto_sync_calls[site][1]
+            args = call_site.get_args()
+            code += f"{indent}{AUTO_SYNC_GENERATED}"
+            code += f"{indent}{func_sig}_{c_identifier(queue)}({args[0]}, {args[1]}, {args[2]});\n"
+        elif func_sig == AUTO_SYNC_PROCEED_ON_EVENT:
+            event = auto_sync_calls[site][1]
+            event_mutex = event_sync_mechanisms[event][0]
+            event_cond_var = event_sync_mechanisms[event][1]
+            event_counter_var = event_sync_mechanisms[event][2]
+            event_generation_var = event_sync_mechanisms[event][3]
+            event_barrier = event_sync_mechanisms[event][4]
+            event_no_of_threads = auto_sync_calls[site][2]
+
+            if event_barrier == AUTO_SYNC_BARRIER_DEFAULT:
+                # The generation is re-checked after every wakeup, so spurious wakeups do not release the thread
+                barrier_body = f'{{\n \
+    uint32_t uiAutoSyncGeneration;\n \
+    {sync_backend.lock(f"&{event_mutex}")};\n \
+    uiAutoSyncGeneration = {event_generation_var};\n \
     {event_counter_var}++;\n \
     if ({event_counter_var} == {event_no_of_threads}) {{\n \
         {event_counter_var} = 0; \n \
-        pthread_cond_broadcast(&{event_cond_var}); \n \
+        {event_generation_var}++; \n \
+        {sync_backend.cond_broadcast(f"&{event_cond_var}")}; \n \
     }} \n \
     else {{ \n \
-        pthread_cond_wait(&{event_cond_var}, &{event_mutex});\n \
+        while (uiAutoSyncGeneration == {event_generation_var}) {{ \n \
+            {sync_backend.cond_wait(f"&{event_cond_var}", f"&{event_mutex}")};\n \
+        }} \n \
     }} \n \
-    pthread_mutex_unlock(&{event_mutex});' 
-
-                    tmp.write(barrier_body)               
-
+    {sync_backend.unlock(f"&{event_mutex}")};\n \
+}}\n'
+            elif event_barrier == AUTO_SYNC_BARRIER_OMP:
+                # A standalone directive, it must not be the only statement of an if or a loop
+                barrier_body = "{\n#pragma omp barrier\n}\n"
+            else:
+                barrier_body = f'iAutoSyncProceedOnEvent_{event}({event_no_of_threads});\n'
+
+            if profile:
+                # The wait of a thread at the event is timed from its arrival until it proceeds
+                profile_sites.append((site, event, event_mutex if event_barrier == AUTO_SYNC_BARRIER_DEFAULT else event_barrier))
+                event_lock = sync_backend.lock(f"&{event_mutex}")
+                barrier_body = barrier_body.replace(f"{event_lock};",
+                                                    f"AUTO_SYNC_PROFILE_TRY_LOCK({sync_backend.try_lock(f'&{event_mutex}')}, {event_lock});")
+                barrier_body = f"{{ AUTO_SYNC_PROFILE_BEGIN();\n{barrier_body}AUTO_SYNC_PROFILE_END({len(profile_sites) - 1}); }}\n"
+
+            # Combine the per-thread accumulators of the reductions of the threads before they proceed
+            for shared_var in reduce_events.get(event, []):
+                code += f"{indent}iAutoSyncReduceCombine_{event}_{c_identifier(shared_var)}({event_no_of_threads});\n"
+
+            code += barrier_body
+
+        if not call_site.braced:
+            # The call was the only statement of an if, a loop or a label, the generated statements need a block
+            code = f"{indent}{{\n{code}{indent}}}\n"
+        return code
+
+    # Calls of every line, in the order of their columns
+    calls_of_line = dict()
+    for call_site in sorted(call_sites.values(), key=lambda call_site: (call_site.line, call_site.column)):
+        calls_of_line.setdefault(call_site.line, []).append(call_site)
+
+    # Every translation unit of the source is written to its own file, starting at its first line
+    with open(path, "r") as source, contextlib.ExitStack() as generated:
+        lines = source.readlines()
+        # Last line of the statement of the previous call, it could span several lines
+        replaced_until = 0
+        for line_no, line in enumerate(lines):
+            line_no += 1
+            if line_no in outputs:
+                tmp = generated.enter_context(open(outputs[line_no], "w"))
+            if line_no in loop_edges:
+                # Code before or after a loop whose critical sections are taken out of it
+                tmp.write(loop_edges[line_no])
+            if line_no <= replaced_until:
+                continue
+
+            if str(line_no) in thread_sections:
+                # Threads of main that run in an OpenMP parallel region
+                tmp.write(thread_sections[str(line_no)])
+            elif str(line_no) in loop_sections:
+                # Update of a shared-variable batched in its loop
+                tmp.write(loop_sections[str(line_no)])
+            elif str(line_no) in combine_sections:
+                # Update of a shared-variable applied by the thread that holds its mutex
+                tmp.write(combine_sections[str(line_no)])
+            elif str(line_no) in atomic_sections.keys():
+                # Shared-variable lowered to C11 atomics, no mutex is needed
+                tmp.write(atomic_sections[str(line_no)])
+            elif str(line_no) in colocated_decls:
+                # Shared-variable moved into the struct of its mutex
+                tmp.write(colocated_decls[str(line_no)])
+            elif line_no in calls_of_line:
+                # Only the source range of every call is replaced, the code around the calls is kept
+                indent = line[:len(line) - len(line.lstrip())]
+                code = ""
+                column = 0
+                while True:
+                    following = [call_site for call_site in calls_of_line.get(line_no, []) if call_site.column > column]
+                    if not following:
+                        break
+                    call_site = following[0]
+                    before = lines[line_no - 1][column:call_site.column - 1]
+                    if before.strip():
+                        # Code in front of the call (e.g. a case label) stays in front of the generated code
+                        code += before + rewrite_call(call_site, indent).lstrip(" \t")
+                    else:
+                        code += rewrite_call(call_site, indent)
+                    line_no, column = call_site.end_line, call_site.end_column
+                rest = lines[line_no - 1][column:]
+                if rest.strip():
+                    code += indent + rest.lstrip()
+                tmp.write(code)
+                replaced_until = line_no
             elif re.match(r"(.*)(AutoSync\.h)", line):
                 tmp.write("#include \"_AutoSync.h\"\n")
             elif re.match(r"(\W*iAutoSyncSharedVarAsArg)", line):
                 tmp.write("")
             elif "xAutoSyncIntentions" in line:
                 tmp.write("")
-            
+
             else:
                 tmp.write(line)
 
+    return profile_sites
+
 
-def assign_mutexes(shared_var_dependencies: dict) -> dict:
+def assign_mutexes(shared_var_dependencies: dict, intentions: dict, threads_info: dict, cost_model: bool) -> dict:
     '''
-    Logic for assigning mutexes to the shared-variables based on the dependencies, type and quantity of accesses.
+    Logic for assigning mutexes to the shared-variables based on the dependencies.
+    Shared-variables that depend on each other, directly or through other shared-variables, are protected by the same
+    mutex: every connected component of the dependencies gets one mutex, named after its first shared-variable.
+    With the cost model, a dependency on a constant shared-variable may be split: it is not written while the threads
+    run, so the shared-variables that depend on it stay consistent without sharing its lock. The split is only done if
+    threads of different instances lock both sides (see get_contention), otherwise one lock is cheaper.
     Returns a dictionary where every shared-variable is a key and has its associated mutex.
+    EXAMPLE:
+        "N": "xMutex_N", "x": "xMutex_N"
     '''
     MUTEX_NAME = "xMutex__DUMMY__"
-    mutexes = dict()
+
+    # Union-find, the root of every component is its first shared-variable
+    order = {shared_var: idx for idx, shared_var in enumerate(shared_var_dependencies)}
+    parents = dict()
+
+    def find(shared_var: str) -> str:
+        parents.setdefault(shared_var, shared_var)
+        while parents[shared_var] != shared_var:
+            parents[shared_var] = parents[parents[shared_var]]
+            shared_var = parents[shared_var]
+        return shared_var
+
+    def union(shared_var_a: str, shared_var_b: str):
+        root_a, root_b = find(shared_var_a), find(shared_var_b)
+        if root_a != root_b:
+            if order.get(root_b, len(order)) < order.get(root_a, len(order)):
+                root_a, root_b = root_b, root_a
+            parents[root_b] = root_a
+
+    # The dependencies that the intentions allow to split are decided once the other ones are merged
+    splittable = list()
     for shared_var, dependencies in shared_var_dependencies.items():
-        # If the shared-variable doesnt have an associated mutex, create one
-        if shared_var not in mutexes.keys():
-            mutexes[shared_var] = MUTEX_NAME.replace("_DUMMY__", shared_var.replace(".", "_").replace("->", "_"))
-        
-        # Assign the same lock for the dependencies
+        find(shared_var)
         for dependency in dependencies:
-            mutexes[dependency] = mutexes[shared_var]
-    
+            if cost_model and ("bConstantInitByMain" in intentions.get(shared_var, []) or \
+                               "bConstantInitByMain" in intentions.get(dependency, [])):
+                find(dependency)
+                splittable.append((shared_var, dependency))
+                continue
+            union(shared_var, dependency)
+
+    for shared_var, dependency in splittable:
+        if find(shared_var) == find(dependency):
+            continue
+        # Constant shared-variables are never locked, they do not contend
+        component = [var for var in parents if find(var) == find(shared_var) and \
+                     "bConstantInitByMain" not in intentions.get(var, [])]
+        dependency_component = [var for var in parents if find(var) == find(dependency) and \
+                                "bConstantInitByMain" not in intentions.get(var, [])]
+        contention = get_contention(threads_info, component, dependency_component)
+        if contention == 0:
+            union(shared_var, dependency)
+        else:
+            print(f"!!! [CODE GENERATOR INFO] {shared_var} does not share the lock of {dependency}, " + \
+                  f"expected contention between them {contention}")
+
+    mutexes = dict()
+    for shared_var in parents:
+        mutexes[shared_var] = MUTEX_NAME.replace("_DUMMY__", find(shared_var).replace(".", "_").replace("->", "_"))
+
     pprint.pprint(mutexes)
     return mutexes
 
 
-def assign_event_sync_mechanisms(auto_sync_calls: dict) -> dict:
+def get_no_of_instances(info: dict) -> int:
+    '''
+    Get the quantity of instances of a thread. The parser gives a C expression instead of a number if the quantity is
+    only known at runtime, these threads are assumed to have RUNTIME_NO_OF_THREADS instances.
+    '''
+    return info["Quantity"] if isinstance(info["Quantity"], int) else RUNTIME_NO_OF_THREADS
+
+
+def get_max_threads(threads_info: dict) -> int:
+    '''
+    Get the size of the per-thread arrays (reduction slots, barrier flags and nodes) if the quantity of every thread
+    is constant. The size is a power of two of at least 2 because the tree barriers halve it in every level.
+    Returns None if a quantity is only known at runtime, the arrays keep the AUTO_SYNC_MAX_THREADS of AutoSync.h.
+    EXAMPLE:
+        {"main": {"Quantity": 1, ...}, "Worker": {"Quantity": 4, ...}} -> 8
+    '''
+    if not all(isinstance(info["Quantity"], int) for info in threads_info.values()):
+        return None
+    total = sum(info["Quantity"] for info in threads_info.values())
+    max_threads = 2
+    while max_threads < total:
+        max_threads *= 2
+    return max_threads
+
+
+def get_contention(threads_info: dict, shared_vars_a: list, shared_vars_b: list) -> int:
+    '''
+    Estimate the contention between the accesses of the threads to two groups of shared-variables.
+    Every instance of a thread (Quantity) accesses the shared-variables as often as its AutoSync calls, an Update is
+    counted with its ReadToUpdate. The contention is the number of pairs of accesses from different thread instances,
+    one to each group, the higher it is the more likely the threads wait for each other if the groups share a lock.
+    The pairs are unordered if both groups are the same.
+    EXAMPLE:
+        {"main": {"Quantity": 1, "Read": ["x"], ...}, "Worker": {"Quantity": 4, "ReadToUpdate": ["x"], ...}}, ["x"], ["x"] -> 10
+    '''
+    total_a, total_b, same_instance = 0, 0, 0
+    for thread, info in threads_info.items():
+        accesses_a = sum(info[access].count(shared_var) for shared_var in shared_vars_a \
+                         for access in ["Read", "Write", "ReadToUpdate", "Reduce"])
+        accesses_b = sum(info[access].count(shared_var) for shared_var in shared_vars_b \
+                         for access in ["Read", "Write", "ReadToUpdate", "Reduce"])
+        total_a += get_no_of_instances(info) * accesses_a
+        total_b += get_no_of_instances(info) * accesses_b
+        same_instance += get_no_of_instances(info) * accesses_a * accesses_b
+    if shared_vars_a == shared_vars_b:
+        return (total_a * total_b - same_instance) // 2
+    return total_a * total_b - same_instance
+
+
+def report_lock_contention(threads_info: dict, mutexes: dict, rwlocks: dict, intentions: dict) -> dict:
+    '''
+    Estimate the contention of every lock with the accesses of the threads to its shared-variables (see
+    get_contention). Constant shared-variables are never locked and are not counted.
+    Returns a dictionary where every lock is a key and has its expected contention.
+    EXAMPLE:
+        "xMutex_Global_id": 1
+    '''
+    locks = dict(mutexes)
+    locks.update({shared_var: rwlock for shared_var, (rwlock, rwlock_type) in rwlocks.items()})
+
+    contention = dict()
+    for lock in sorted(set(locks.values())):
+        shared_vars = [shared_var for shared_var, var_lock in locks.items() \
+                       if var_lock == lock and "bConstantInitByMain" not in intentions.get(shared_var, [])]
+        if not shared_vars:
+            continue
+        total = sum(get_no_of_instances(info) * info[access].count(shared_var) for info in threads_info.values() \
+                    for shared_var in shared_vars for access in ["Read", "Write", "ReadToUpdate", "Reduce"])
+        contention[lock] = get_contention(threads_info, shared_vars, shared_vars)
+        print(f"!!! [CODE GENERATOR INFO] {lock} protects {len(shared_vars)} shared-variables, " + \
+              f"{total} accesses per run, expected contention {contention[lock]}")
+    return contention
+
+
+def assign_sliced_arrays(sliced_arrays: dict, mutexes: dict, intentions: dict) -> dict:
+    '''
+    Logic for replacing the mutex of the sliced arrays by one mutex per slice (lock striping).
+    The range uiFirstAccess..uiLastAccess gives the quantity of stripes, limited to LOCK_STRIPES.
+    If the parser proved that every thread only accesses its own slice, the array does not need a lock at all.
+    An array keeps its mutex if it is shared with other shared-variables that are locked.
+    Returns a dictionary where every striped array is a key and has its associated stripes, quantity of stripes 
+    and first accessed element. The stripes are empty if the array does not need a lock.
+    EXAMPLE:
+        "Global->transtimes": ("xMutexStripes_Global_transtimes", 64, 0)
+    '''
+    STRIPES_NAME = "xMutexStripes__DUMMY__"
+
+    striped_arrays = dict()
+    for shared_var, sliced_array in sliced_arrays.items():
+        if shared_var not in mutexes or "bConstantInitByMain" in intentions.get(shared_var, []):
+            continue
+
+        # Other shared-variables that are locked with the same mutex still need the whole array to be locked
+        coupled_vars = [var for var, mutex in mutexes.items() if mutex == mutexes[shared_var] and var != shared_var and \
+                        not ("bConstantInitByMain" in intentions.get(var, []))]
+        if coupled_vars:
+            continue
+
+        first_access = sliced_array["FirstAccess"]
+        last_access = sliced_array["LastAccess"]
+        no_of_stripes = LOCK_STRIPES
+        if last_access > first_access:
+            no_of_stripes = min(last_access - first_access + 1, LOCK_STRIPES)
+
+        if sliced_array["Disjoint"]:
+            striped_arrays[shared_var] = ("", no_of_stripes, first_access)
+        else:
+            striped_arrays[shared_var] = (STRIPES_NAME.replace("_DUMMY__", c_identifier(shared_var)), no_of_stripes, first_access)
+
+    pprint.pprint(striped_arrays)
+    return striped_arrays
+
+
+def get_striped_arrays(sliced_arrays: dict) -> dict:
+    '''
+    Get the sliced arrays that are protected by stripes, i.e. the ones that still need a lock.
+    '''
+    return {shared_var: striped for shared_var, striped in sliced_arrays.items() if striped[0]}
+
+
+def assign_rwlocks(threads_info: dict, auto_sync_calls: dict, mutexes: dict, intentions: dict, reductions: dict, seqlocks: dict, lock_profile: dict) -> dict:
+    '''
+    Logic for replacing mutexes by reader-writer locks based on the share of read accesses.
+    The accesses of every thread are weighted with the quantity of the thread. The shared-variables that share 
+    a mutex get a reader-writer lock if at least READ_SHARE_RWLOCK of their accesses are reads.
+    If none of the shared-variables is updated with a ReadToUpdate/Update pair, all critical sections are a single
+    copy and a writer-preferring spin lock is used. Otherwise, a writer-preferring pthread_rwlock_t is used.
+    With a lock profile, the accesses are the acquisitions of the run and the contention decides instead:
+    cold mutexes stay mutexes, hot ones become spin locks if they are held shortly (a spin reader-writer lock
+    that is mostly written is a spin lock) and pthread_rwlock_t if they are read-heavy but held longer.
+    Reader-writer locks are not recursive, so the mutex is kept if it is locked again inside a ReadToUpdate/Update pair.
+    pthread_rwlock_t is only used with the pthread backend, the mutex is kept where the other backends would need it.
+    The optimistic reads of the shared-variables with sequence locks do not lock, so they are not counted.
+    Returns a dictionary where every shared-variable is a key and has its associated reader-writer lock and type.
+    EXAMPLE:
+        "x": ("xRWLock_x", "pthread_rwlock_t")
+    '''
+    RWLOCK_NAME = "xRWLock__DUMMY__"
+
+    # Shared-variables initialized by main are never locked
+    locked_vars = {shared_var: mutex for shared_var, mutex in mutexes.items() \
+                   if not ("bConstantInitByMain" in intentions.get(shared_var, []))}
+    reads = dict.fromkeys(locked_vars.values(), 0)
+    writes = dict.fromkeys(locked_vars.values(), 0)
+    contended = dict.fromkeys(locked_vars.values(), 0)
+    hold_ns = dict.fromkeys(locked_vars.values(), 0)
+    excluded = [locked_vars[shared_var] for shared_var in reductions if shared_var in locked_vars]
+
+    profiled = lock_profile is not None
+    if not profiled:
+        for thread, usage in threads_info.items():
+            # Functions that are not threads are called by a thread at least once
+            weight = max(get_no_of_instances(usage), 1)
+            for shared_var in usage["Read"]:
+                if shared_var in locked_vars and shared_var not in seqlocks:
+                    reads[locked_vars[shared_var]] += weight
+            # A ReadToUpdate/Update pair is one critical section
+            for shared_var in usage["Write"] + usage["ReadToUpdate"]:
+                if shared_var in locked_vars:
+                    writes[locked_vars[shared_var]] += weight
+    else:
+        for shared_var, counts in lock_profile.items():
+            if shared_var not in locked_vars:
+                continue
+            reads[locked_vars[shared_var]] += counts["Reads"]
+            writes[locked_vars[shared_var]] += counts["Writes"]
+            contended[locked_vars[shared_var]] += counts["Contended"]
+            hold_ns[locked_vars[shared_var]] += counts["HoldNs"]
+
+    # Check which mutexes are locked again inside a ReadToUpdate/Update pair or protect a pair
+    updated = []
+    open_mutex = None
+    for line, func_call in sorted(auto_sync_calls.items(), key=lambda call: get_site_order(call[0])):
+        if func_call[0] == AUTO_SYNC_PROCEED_ON_EVENT or func_call[1] not in locked_vars or \
+           (func_call[0] == AUTO_SYNC_READ and func_call[1] in seqlocks):
+            continue
+        mutex = locked_vars[func_call[1]]
+        if func_call[0] == AUTO_SYNC_READ_TO_UPDATE:
+            updated.append(mutex)
+            if open_mutex == mutex:
+                excluded.append(mutex)
+            open_mutex = mutex
+        elif func_call[0] == AUTO_SYNC_UPDATE and open_mutex == mutex:
+            open_mutex = None
+        elif open_mutex == mutex:
+            excluded.append(mutex)
+
+    rwlocks = dict()
+    for shared_var, mutex in locked_vars.items():
+        accesses = reads[mutex] + writes[mutex]
+        if mutex in excluded or accesses == 0:
+            continue
+        if not profiled:
+            if reads[mutex] / accesses < READ_SHARE_RWLOCK:
+                continue
+            rwlock_type = RWLOCK if mutex in updated else SPIN_RWLOCK
+        elif contended[mutex] / accesses < PROFILE_CONTENDED_SHARE:
+            continue
+        elif hold_ns[mutex] / accesses < PROFILE_SPIN_HOLD_NS:
+            rwlock_type = SPIN_RWLOCK
+        elif reads[mutex] / accesses >= READ_SHARE_RWLOCK:
+            rwlock_type = RWLOCK
+        else:
+            continue
+        if rwlock_type == RWLOCK and not sync_backend.rwlocks:
+            continue
+        rwlocks[shared_var] = (RWLOCK_NAME.replace("_DUMMY__", mutex[len("xMutex_"):]), rwlock_type)
+
+    if profiled:
+        for mutex in sorted(set(locked_vars.values())):
+            accesses = reads[mutex] + writes[mutex]
+            lock_type = next((rwlock[1] for shared_var, rwlock in rwlocks.items() if locked_vars[shared_var] == mutex), sync_backend.mutex_type)
+            print(f"!!! [CODE GENERATOR INFO] {mutex}: {accesses} acquisitions, {contended[mutex]} contended, " + \
+                  f"{hold_ns[mutex] // max(accesses, 1)} ns held on average -> {lock_type}")
+
+    pprint.pprint(rwlocks)
+    return rwlocks
+
+
+def get_lock_profile(path: str, auto_sync_calls: dict) -> dict:
+    '''
+    Read a lock profile dumped by a run of a program generated with --profile-locks and sum it per shared-variable.
+    The acquisitions of the Read sites are reads, the ones of the Write and ReadToUpdate sites are writes.
+    Sites that are not an AutoSync call of the shared-variable anymore (the source changed since the run) are ignored.
+    The waits at the events are profiled too, they do not choose a lock and are skipped.
+    Returns a dictionary where every profiled shared-variable is a key and has its summed counters.
+    EXAMPLE:
+        "Global->id": {"Reads": 0, "Writes": 4, "Contended": 1, "WaitNs": 2110, "HoldNs": 380}
+    '''
+    try:
+        with open(path, "r") as file:
+            profile = json.load(file)
+    except (OSError, ValueError) as ex:
+        print(f"[CODE GENERATOR ERROR] Could not read the lock profile {path}: {ex}")
+        exit(1)
+
+    lock_profile = dict()
+    for shared_var, sites in profile.items():
+        for line_no, counters in sites.items():
+            func_call = auto_sync_calls.get(line_no)
+            if func_call is not None and func_call[0] == AUTO_SYNC_PROCEED_ON_EVENT:
+                continue
+            if func_call is None or func_call[0] not in [AUTO_SYNC_READ, AUTO_SYNC_WRITE, AUTO_SYNC_READ_TO_UPDATE] or \
+               func_call[1] != shared_var:
+                print(f"!!! [CODE GENERATOR INFO] Lock profile of {shared_var} at line {line_no} does not match the source, it is ignored")
+                continue
+            counts = lock_profile.setdefault(shared_var, {"Reads": 0, "Writes": 0, "Contended": 0, "WaitNs": 0, "HoldNs": 0})
+            counts["Reads" if func_call[0] == AUTO_SYNC_READ else "Writes"] += counters["Acquisitions"]
+            counts["Contended"] += counters["Contended"]
+            counts["WaitNs"] += counters["WaitNs"]
+            counts["HoldNs"] += counters["HoldNs"]
+
+    pprint.pprint(lock_profile)
+    return lock_profile
+
+
+def assign_seqlocks(intentions: dict, mutexes: dict, reductions: dict) -> dict:
+    '''
+    Logic for assigning sequence locks to the shared-variables with the intention bOptimisticRead.
+    Their reads do not lock, the writers are still serialized by the mutex or reader-writer lock of the shared-variable.
+    Reduced shared-variables are also written by the combine functions, so they do not get a sequence lock either.
+    Shared-variables that are lowered to atomics or striped are not locked by a single lock.
+    Returns a dictionary where every shared-variable is a key and has its associated sequence.
+    EXAMPLE:
+        "xConfig": "uiSeqLock_xConfig"
+    '''
+    SEQLOCK_NAME = "uiSeqLock__DUMMY__"
+
+    seqlocks = dict()
+    for shared_var, var_intentions in intentions.items():
+        if "bOptimisticRead" not in var_intentions:
+            continue
+        if "bConstantInitByMain" in var_intentions or shared_var not in mutexes or shared_var in reductions:
+            print(f"!!! [CODE GENERATOR INFO] bOptimisticRead is ignored for {shared_var}, it is not protected by a single lock")
+            continue
+        seqlocks[shared_var] = SEQLOCK_NAME.replace("_DUMMY__", c_identifier(shared_var))
+
+    pprint.pprint(seqlocks)
+    return seqlocks
+
+
+def assign_colocations(path: str, global_vars: dict, mutexes: dict, intentions: dict, layout: str) -> tuple:
+    '''
+    Logic for placing a mutex in the same struct as the shared-variable that it protects, so one acquisition
+    brings both into the cache. Only global shared-variables with a basic type and one declarator in their
+    declaration are moved, and only if the mutex does not protect other shared-variables that are locked.
+    The shared-variable is then a macro to its field in the struct.
+    Returns a dictionary where every co-located shared-variable is a key and has its associated struct and type,
+    and a dictionary with the generated code that replaces the original declarations.
+    EXAMPLE:
+        {"dCounter": ("xLocked_dCounter", "double")},
+        {"17": "xLocked_dCounterType xLocked_dCounter = {.xValue = 0};\n#define dCounter (xLocked_dCounter.xValue)\n"}
+    '''
+    COLOCATED_NAME = "xLocked__DUMMY__"
+    if layout != LAYOUT_COLOCATED:
+        return dict(), dict()
+
+    with open(path, "r") as source:
+        lines = source.readlines()
+
+    locked_mutexes = [mutex for shared_var, mutex in mutexes.items() \
+                      if not ("bConstantInitByMain" in intentions.get(shared_var, []))]
+    colocated = dict()
+    colocated_decls = dict()
+    for shared_var, mutex in mutexes.items():
+        if shared_var not in global_vars or locked_mutexes.count(mutex) != 1 or \
+           "bConstantInitByMain" in intentions.get(shared_var, []):
+            continue
+        var_type = global_vars[shared_var]["Type"]
+        line_no = global_vars[shared_var]["Line"]
+        if not all(word in BASIC_TYPES for word in var_type.split()):
+            continue
+
+        line = lines[line_no - 1]
+        match = re.fullmatch(r"\s*" + r"\s+".join(var_type.split()) + r"\s+" + re.escape(shared_var) + \
+                             r"\s*(=\s*([^;]+?))?\s*;\s*(/\*.*\*/|//.*)?\s*", line)
+        if match is None:
+            continue
+
+        colocated_var = COLOCATED_NAME.replace("_DUMMY__", shared_var)
+        init = match.group(2) if match.group(2) else "0"
+        colocated[shared_var] = (colocated_var, var_type)
+        colocated_decls[str(line_no)] = f"{AUTO_SYNC_GENERATED}{colocated_var}Type {colocated_var} = {{.xValue = {init}}};\n" + \
+                                        f"#define {shared_var} ({colocated_var}.xValue)\n"
+        mutexes[shared_var] = f"{colocated_var}.xMutex"
+
+    pprint.pprint(colocated)
+    return colocated, colocated_decls
+
+
+def assign_mutex_types(call_graph: dict, auto_sync_calls: dict, mutexes: dict, intentions: dict, sliced_arrays: dict, 
+                       seqlocks: dict, reductions: dict, reduce_events: dict, events_mutexes: list) -> dict:
+    '''
+    Logic for dropping PTHREAD_MUTEX_RECURSIVE from the mutexes that are never locked twice by the same thread.
+    Only the ReadToUpdate/Update pairs keep a mutex locked while other code runs. A mutex is recursive if a pair
+    calls AutoSync or, through the call graph, a function that locks the same mutex, or calls a function pointer.
+    Mutexes that only protect single copies are adaptive (spin shortly before sleeping), the others are normal.
+    Returns a dictionary where every mutex is a key and has its associated type.
+    EXAMPLE:
+        "xMutex_Global_id": "PTHREAD_MUTEX_NORMAL"
+    '''
+    def get_locked_mutexes(func_call: list) -> set:
+        # Mutexes locked by an AutoSync call
+        func_sig = func_call[0]
+        if func_sig == AUTO_SYNC_PROCEED_ON_EVENT:
+            # The per-thread accumulators of the reductions are combined under their mutexes
+            return {mutexes[shared_var] for shared_var in reduce_events.get(func_call[1], [])}
+        shared_var = func_call[1]
+        if "bConstantInitByMain" in intentions.get(shared_var, []) or \
+           (func_sig == AUTO_SYNC_READ and shared_var in seqlocks) or \
+           (func_sig == AUTO_SYNC_REDUCE and shared_var in get_typed_reductions(reductions)):
+            return set()
+        if shared_var in mutexes:
+            return {mutexes[shared_var]}
+        if shared_var in get_striped_arrays(sliced_arrays):
+            # Different elements could map to the same stripe, so all stripes are handled as one mutex
+            return {sliced_arrays[shared_var][0]}
+        return set()
+
+    # The call graph only has the line of a call, a line could have several AutoSync calls
+    calls_of_line = dict()
+    for site, func_call in sorted(auto_sync_calls.items(), key=lambda call: get_site_order(call[0])):
+        calls_of_line.setdefault(get_site_line(site), []).append(func_call)
+
+    def get_call(line_no: int, callee: str) -> list:
+        return next((func_call for func_call in calls_of_line.get(line_no, []) if func_call[0] == callee), None)
+
+    # Mutexes locked by every function, including the ones locked by its callees
+    locked_by_func = dict()
+    for func, calls in call_graph.items():
+        locked_by_func[func] = set()
+        for line_no, callee in calls:
+            if get_call(line_no, callee) is not None:
+                locked_by_func[func] |= get_locked_mutexes(get_call(line_no, callee))
+
+    changed = True
+    while changed:
+        changed = False
+        for func, calls in call_graph.items():
+            for line_no, callee in calls:
+                if callee in locked_by_func and not locked_by_func[callee] <= locked_by_func[func]:
+                    locked_by_func[func] |= locked_by_func[callee]
+                    changed = True
+
+    all_mutexes = set(mutexes.values()) | {striped[0] for striped in get_striped_arrays(sliced_arrays).values()}
+    recursive = set()
+    updated = set()
+    for func, calls in call_graph.items():
+        calls = sorted(calls)
+        for idx, (line_no, callee) in enumerate(calls):
+            if callee != AUTO_SYNC_READ_TO_UPDATE or get_call(line_no, callee) is None:
+                continue
+            shared_var = get_call(line_no, callee)[1]
+            pair_mutexes = get_locked_mutexes(get_call(line_no, callee))
+            updated |= pair_mutexes
+
+            # Check every call until the Update that closes the pair
+            closed = False
+            for inner_line_no, inner_callee in calls[idx + 1:]:
+                inner_call = get_call(inner_line_no, inner_callee)
+                if inner_callee == AUTO_SYNC_UPDATE and inner_call is not None and inner_call[1] == shared_var:
+                    closed = True
+                    break
+                if inner_callee == "":
+                    locked = all_mutexes
+                elif inner_call is not None:
+                    locked = get_locked_mutexes(inner_call)
+                else:
+                    locked = locked_by_func.get(inner_callee, set())
+                recursive |= pair_mutexes & locked
+
+            # The pair is closed in another function, so the mutex could be locked anywhere in between
+            if not closed:
+                recursive |= pair_mutexes
+
+    mutex_types = dict()
+    for mutex in all_mutexes:
+        if mutex in recursive:
+            mutex_types[mutex] = MUTEX_RECURSIVE
+        elif mutex in updated:
+            mutex_types[mutex] = MUTEX_NORMAL
+        else:
+            mutex_types[mutex] = MUTEX_ADAPTIVE
+    # The events only lock their mutexes to wait on their condition variables
+    for mutex in events_mutexes:
+        mutex_types[mutex] = MUTEX_NORMAL
+
+    pprint.pprint(mutex_types)
+    return mutex_types
+
+
+def assign_coalesced_sections(path: str, call_sites: dict, auto_sync_calls: dict, mutexes: dict, intentions: dict, atomic_sections: dict,
+                              sliced_arrays: dict, array_indexes: dict, rwlocks: dict, seqlocks: dict, single_threaded_sites: set) -> tuple:
+    '''
+    Logic for merging the critical sections of AutoSync calls on consecutive lines that take the same lock.
+    The unlock of the first call and the lock of the next one are dropped, so the lock is only taken once.
+    Only calls that are whole statements are merged, a line with a label or any other code ends the basic block.
+    Copies of constant shared-variables and single-threaded copies do not lock and can stay inside a merged critical section.
+    Accesses to a single stripe are not merged, the copy before could change the index of the element.
+    Returns the lines whose lock is dropped and the lines whose unlock is dropped.
+    EXAMPLE:
+        ({"317"}, {"316"})
+    '''
+    AUTO_SYNC_LOCKING = [AUTO_SYNC_READ, AUTO_SYNC_WRITE, AUTO_SYNC_READ_TO_UPDATE, AUTO_SYNC_UPDATE]
+
+    elided_locks = set()
+    elided_unlocks = set()
+    with open(path, "r") as source:
+        lines = source.readlines()
+
+    # Line and lock of the previous call whose critical section is still open
+    held = None
+    for line_no, line in enumerate(lines):
+        line_no = str(line_no + 1)
+        if line_no not in auto_sync_calls or line_no in atomic_sections:
+            held = None
+            continue
+        func_sig, shared_var = auto_sync_calls[line_no][0], auto_sync_calls[line_no][1]
+        if func_sig not in AUTO_SYNC_LOCKING or not call_sites[line_no].is_own_line(lines):
+            held = None
+            continue
+        if "bConstantInitByMain" in intentions.get(shared_var, []) or line_no in single_threaded_sites:
+            if func_sig not in [AUTO_SYNC_READ, AUTO_SYNC_WRITE]:
+                held = None
+            continue
+        if (func_sig == AUTO_SYNC_READ and shared_var in seqlocks) or array_indexes.get(line_no) or \
+           not (shared_var in mutexes or shared_var in rwlocks or shared_var in get_striped_arrays(sliced_arrays)):
+            held = None
+            continue
+
+        lock = lock_shared_var(shared_var, "", mutexes, sliced_arrays, rwlocks, func_sig != AUTO_SYNC_READ)
+        if held is not None and held[1] == lock and func_sig != AUTO_SYNC_UPDATE:
+            elided_unlocks.add(held[0])
+            elided_locks.add(line_no)
+
+        # The lock of a ReadToUpdate stays taken for the code until its Update
+        held = None if func_sig == AUTO_SYNC_READ_TO_UPDATE else (line_no, lock)
+
+    if elided_locks:
+        print(f"!!! [CODE GENERATOR INFO] {len(elided_locks)} critical sections merged with the previous one")
+    return elided_locks, elided_unlocks
+
+
+def get_simple_update(local_var: str, body: list) -> tuple:
+    '''
+    Check if the code between a ReadToUpdate/Update pair is a simple arithmetic update of the local copy.
+    Returns a tuple with the compound operator and the operand if the update maps to a single atomic_fetch_*,
+    ("", "") if the update needs a CAS loop and None if it cannot be lowered to atomics at all.
+    EXAMPLE:
+        "uiCountLocal++;" -> ("+=", "1")
+        "local_dostats = !local_dostats;" -> ("", "")
+    '''
+    var = re.escape(local_var)
+    statements = []
+    for line in body:
+        line = re.sub(r"/\*.*?\*/|//.*", "", line).strip()
+        statements += [statement.strip() for statement in line.split(";") if statement.strip()]
+
+    if not statements:
+        return None
+
+    for statement in statements:
+        # Function calls are not simple arithmetic (sizeof is evaluated at compile time)
+        if re.search(r"\b(?!sizeof\b)\w+\s*\(", statement):
+            return None
+        if re.fullmatch(r"(\+\+|--)\s*" + var + r"|" + var + r"\s*(\+\+|--)", statement):
+            continue
+        match = re.fullmatch(var + r"\s*(=|[-+*/%&|^]=|<<=|>>=)\s*(.+)", statement)
+        if match is None or re.search(r"(?<![=!<>])=(?!=)|\+\+|--", match.group(2)):
+            return None
+
+    if len(statements) == 1:
+        statement = statements[0]
+        if "++" in statement:
+            return ("+=", "1")
+        if "--" in statement:
+            return ("-=", "1")
+        match = re.fullmatch(var + r"\s*([-+|&^]=)\s*(.+)", statement)
+        if match and not re.search(r"\b" + var + r"\b", match.group(2)):
+            return (match.group(1), match.group(2).strip())
+
+    return ("", "")
+
+
+def is_dead_local(call_site: CallSite, update: CallSite, local_var: str) -> bool:
+    '''
+    Check if the local copy of a ReadToUpdate/Update pair is only used by the pair (both calls are statements of
+    the same block), so the value of the shared-variable does not have to be copied into it.
+    '''
+    block = call_site.ancestors[-1]
+    if not isinstance(block, c_ast.Compound) or update.ancestors[-1] is not block:
+        return False
+    func_def = next(node for node in call_site.ancestors if isinstance(node, c_ast.FuncDef))
+    pair = block.block_items[block.block_items.index(call_site.node):block.block_items.index(update.node) + 1]
+    def count_uses(nodes: list) -> int:
+        return sum(1 for node in nodes for sub_node in iter_nodes(node) if isinstance(sub_node, c_ast.ID) and sub_node.name == local_var)
+    return count_uses([func_def.body]) == count_uses(pair)
+
+
+def get_local_decl_line(call_site: CallSite, local_var: str, lines: list) -> str:
+    '''
+    Get the source line of the declaration of a local variable of the function of a call, if the declaration
+    is the only code of its line and has no initializer, so the whole line can be removed.
+    Returns None otherwise.
+    EXAMPLE:
+        "    uint32_t uiCountLocal;\n" -> "147"
+    '''
+    func_def = next(node for node in call_site.ancestors if isinstance(node, c_ast.FuncDef))
+    decls = [node for node in iter_nodes(func_def.body) if isinstance(node, c_ast.Decl) and node.name == local_var]
+    if len(decls) != 1 or decls[0].init is not None or decls[0].coord.file != call_site.node.coord.file:
+        return None
+    line_no = decls[0].coord.line + call_site.line - call_site.node.coord.line
+    if not re.fullmatch(r"[\w\s]*\b" + re.escape(local_var) + r"\s*;", re.sub(r"/\*.*?\*/|//.*", "", lines[line_no - 1]).strip()):
+        return None
+    return str(line_no)
+
+
+def get_atomic_decl(lines: list, shared_var: str, var_type: str) -> tuple:
+    '''
+    Get the global declaration of a shared-variable as an _Atomic declaration, so every access to it is atomic.
+    The declaration must be the only declaration of the shared-variable in the source (e.g. no extern declaration
+    in another translation unit) and have a single declarator.
+    Returns a tuple with the line of the declaration and the new declaration, or None if it cannot be replaced.
+    EXAMPLE:
+        "uint32_t uiCountOccurrences = 0;" -> ("27", "_Atomic uint32_t uiCountOccurrences = 0;\n")
+    '''
+    type_re = r"\s+".join(var_type.split())
+    decls = [line_no for line_no, line in enumerate(lines, 1) \
+             if re.match(r"\s*(extern\s+|static\s+|volatile\s+)*" + type_re + r"\s+" + re.escape(shared_var) + r"\s*[=;,\[]", line)]
+    if len(decls) != 1:
+        return None
+    match = re.fullmatch(r"((static\s+|volatile\s+)*)" + type_re + r"\s+" + re.escape(shared_var) + \
+                         r"\s*(=\s*[^;,]+?)?\s*;\s*((/\*.*\*/|//.*)?)\s*", lines[decls[0] - 1])
+    if match is None:
+        return None
+    init = f" {match.group(3)}" if match.group(3) else ""
+    comment = f" {match.group(4)}" if match.group(4) else ""
+    return str(decls[0]), f"{AUTO_SYNC_GENERATED}{match.group(1)}_Atomic {var_type} {shared_var}{init};{comment}\n"
+
+
+def assign_atomic_updates(path: str, call_sites: dict, auto_sync_calls: dict, mutexes: dict, intentions: dict, shared_var_types: dict) -> tuple:
     '''
-    Logic for assigning mutexes and condition variables to the events.
-    Returns a dictionary where every event is a key and has its associated mutex and conditon variable.
+    Logic for lowering scalar shared-variables to C11 atomics instead of a mutex.
+    A shared-variable is lowered if its type is an integer of at most 8 bytes, it does not share its mutex
+    with other shared-variables and every ReadToUpdate/Update pair only does a simple arithmetic update.
+    All the accesses to a lowered shared-variable must be atomic, so it is declared _Atomic (see get_atomic_decl),
+    its Read/Write become atomic loads/stores and its calls must pass its address (&shared_var).
+    With the OpenMP backend, the accesses are #pragma omp atomic instead and updates that need a CAS loop keep the mutex.
+    Returns a dictionary with the type of the lowered shared-variables and a dictionary with the generated code
+    for every source line that belongs to their accesses.
     EXAMPLE:
-        "TransposeDone": ["xMutex_TransposeDone", "xCondVar_TransposeDone"]
+        {"uiCountOccurrences": "uint32_t"},
+        {"27": "_Atomic uint32_t uiCountOccurrences = 0;\n", "103": "uiCountLocal = atomic_fetch_add_explicit(...) + 1;\n", "104": "", "105": ""}
+    '''
+    with open(path, "r") as source:
+        lines = source.readlines()
+
+    mutexes_in_use = list(mutexes.values())
+    candidates = dict()
+    atomic_decls = dict()
+    for shared_var, mutex in mutexes.items():
+        var_type = shared_var_types.get(shared_var, "")
+        if var_type and all(word in ATOMIC_INTEGER_TYPES for word in var_type.split()) and \
+           mutexes_in_use.count(mutex) == 1 and \
+           not ("bConstantInitByMain" in intentions.get(shared_var, [])):
+            # The OpenMP atomic constructs do not accept _Atomic variables, every access is a construct instead
+            atomic_decl = get_atomic_decl(lines, shared_var, var_type)
+            if atomic_decl is None and not sync_backend.openmp:
+                continue
+            candidates[shared_var] = var_type
+            atomic_decls[shared_var] = atomic_decl
+
+    calls = sorted(auto_sync_calls.items(), key=lambda call: get_site_order(call[0]))
+    sections = {shared_var: dict() for shared_var in candidates}
+    for idx, (line_no, func_call) in enumerate(calls):
+        func_sig = func_call[0]
+        if func_sig == AUTO_SYNC_PROCEED_ON_EVENT or func_call[1] not in sections:
+            continue
+
+        shared_var = func_call[1]
+        def omp_lvalue(arg: str) -> str:
+            return deref_arg(arg) if arg.startswith("&") else f"*({candidates[shared_var]} *)({arg})"
+        if not call_sites[line_no].is_own_line(lines):
+            # The line has other code, it cannot be replaced as a whole
+            sections[shared_var] = None
+            continue
+        line = lines[int(line_no) - 1]
+        indent = line[:len(line) - len(line.lstrip())]
+        args = get_call_args(line, func_sig)
+        if sections[shared_var] is None or line_no in sections[shared_var]:
+            continue
+        if len(args) != 4 or (not sync_backend.openmp and \
+                              re.sub(r"\s", "", args[0 if func_sig in [AUTO_SYNC_WRITE, AUTO_SYNC_UPDATE] else 1]) != f"&{shared_var}"):
+            sections[shared_var] = None
+            continue
+
+        if func_sig == AUTO_SYNC_READ and sync_backend.openmp:
+            sections[shared_var][line_no] = f"{indent}{AUTO_SYNC_GENERATED}{indent}#pragma omp atomic read seq_cst\n" + \
+                f"{indent}{deref_arg(args[0])} = {omp_lvalue(args[1])};\n"
+        elif func_sig == AUTO_SYNC_READ:
+            sections[shared_var][line_no] = f"{indent}{AUTO_SYNC_GENERATED}" + \
+                f"{indent}{deref_arg(args[0])} = atomic_load_explicit(&{shared_var}, memory_order_acquire);\n"
+        elif func_sig == AUTO_SYNC_WRITE and sync_backend.openmp:
+            sections[shared_var][line_no] = f"{indent}{AUTO_SYNC_GENERATED}{indent}#pragma omp atomic write seq_cst\n" + \
+                f"{indent}{omp_lvalue(args[0])} = {deref_arg(args[1])};\n"
+        elif func_sig == AUTO_SYNC_WRITE:
+            sections[shared_var][line_no] = f"{indent}{AUTO_SYNC_GENERATED}" + \
+                f"{indent}atomic_store_explicit(&{shared_var}, {deref_arg(args[1])}, memory_order_release);\n"
+        elif func_sig == AUTO_SYNC_READ_TO_UPDATE and idx + 1 < len(calls):
+            # The pair must be closed by the next AutoSync call, using the same local copy
+            update_line_no, update_call = calls[idx + 1]
+            if not call_sites[update_line_no].is_own_line(lines):
+                sections[shared_var] = None
+                continue
+            update_args = get_call_args(lines[int(update_line_no) - 1], AUTO_SYNC_UPDATE)
+            if update_call[0] != AUTO_SYNC_UPDATE or update_call[1] != shared_var or \
+               len(update_args) != 4 or update_args[1] != args[0]:
+                sections[shared_var] = None
+                continue
+
+            local_var = deref_arg(args[0])
+            body = lines[int(line_no):int(update_line_no) - 1]
+            update = get_simple_update(local_var, body)
+            if update is None or (sync_backend.openmp and not update[0]):
+                sections[shared_var] = None
+                continue
+
+            operator, operand = update
+            if not all(word in ATOMIC_FETCH_TYPES for word in candidates[shared_var].split()):
+                # Updates of a bool are CAS loops, OpenMP has no construct for them
+                if sync_backend.openmp:
+                    sections[shared_var] = None
+                    continue
+                operator = ""
+            # A local copy that is only used by the pair does not get the new value, its declaration is removed
+            decl_line = None
+            if operator and re.fullmatch(r"\w+", local_var) and \
+               is_dead_local(call_sites[line_no], call_sites[update_line_no], local_var):
+                decl_line = get_local_decl_line(call_sites[line_no], local_var, lines)
+            code = f"{indent}{AUTO_SYNC_GENERATED}"
+            if sync_backend.openmp and decl_line is not None:
+                code += f"{indent}#pragma omp atomic seq_cst\n"
+                code += f"{indent}{omp_lvalue(args[1])} {operator} {operand};\n"
+            elif sync_backend.openmp:
+                if not re.fullmatch(r"\w+", operand):
+                    operand = f"({operand})"
+                code += f"{indent}#pragma omp atomic capture seq_cst\n"
+                code += f"{indent}{local_var} = {omp_lvalue(args[1])} {operator} {operand};\n"
+            elif decl_line is not None:
+                code += f"{indent}{ATOMIC_FETCH_OPS[operator]}(&{shared_var}, {operand}, memory_order_acq_rel);\n"
+            elif operator:
+                if not re.fullmatch(r"\w+", operand):
+                    operand = f"({operand})"
+                code += f"{indent}{local_var} = {ATOMIC_FETCH_OPS[operator]}(&{shared_var}, " + \
+                        f"{operand}, memory_order_acq_rel) {operator[0]} {operand};\n"
+            else:
+                code += f"{indent}{{\n"
+                code += f"{indent}  {candidates[shared_var]} xAutoSyncExpected = " + \
+                        f"atomic_load_explicit(&{shared_var}, memory_order_relaxed);\n"
+                code += f"{indent}  do {{\n"
+                code += f"{indent}    {local_var} = xAutoSyncExpected;\n"
+                code += "".join(f"    {body_line}" if body_line.strip() else body_line for body_line in body)
+                code += f"{indent}  }} while (!atomic_compare_exchange_weak_explicit(&{shared_var}, " + \
+                        f"&xAutoSyncExpected, {local_var}, memory_order_acq_rel, memory_order_acquire));\n"
+                code += f"{indent}}}\n"
+
+            sections[shared_var][line_no] = code
+            for body_line_no in range(int(line_no) + 1, int(update_line_no) + 1):
+                sections[shared_var][str(body_line_no)] = ""
+            if decl_line is not None:
+                sections[shared_var][decl_line] = ""
+        else:
+            # Update without a preceding ReadToUpdate
+            sections[shared_var] = None
+
+    atomic_vars = dict()
+    atomic_sections = dict()
+    for shared_var, var_sections in sections.items():
+        if var_sections:
+            atomic_vars[shared_var] = candidates[shared_var]
+            atomic_sections.update(var_sections)
+            if atomic_decls[shared_var] is not None and not sync_backend.openmp:
+                atomic_sections[atomic_decls[shared_var][0]] = atomic_decls[shared_var][1]
+
+    pprint.pprint(atomic_vars)
+    return atomic_vars, atomic_sections
+
+
+def assign_loop_batches(path: str, call_sites: dict, auto_sync_calls: dict, mutexes: dict, intentions: dict, atomic_vars: dict,
+                        shared_var_types: dict, elided_locks: set, elided_unlocks: set, batch_size: int) -> tuple:
+    '''
+    Logic for taking the critical section of a ReadToUpdate/Update pair out of the innermost loop around it. The pair
+    must be the only call of the loop and the loop can only be left by its condition or a break.
+    If the pair is the whole body of the loop, the mutex is locked once around the loop instead of once per iteration.
+    If the shared-variable has the intention bDeferredUpdate and the pair does a simple arithmetic update of an
+    integer, the updates are combined in a local variable and applied every batch_size updates and after the loop.
+    Returns the generated code for the lines of the batched pairs, the code inserted in front of the first line of
+    the loops and behind their last line, and the ReadToUpdate calls whose lock and Update calls whose unlock are
+    taken out of their loop.
+    EXAMPLE:
+        {"154": "xAutoSyncBatch_uiCountOccurrences_150 += 1;\n...", "155": "", "156": ""},
+        {150: "uint32_t xAutoSyncBatch_uiCountOccurrences_150 = 0;\n...", 159: "if (uiAutoSyncBatched_uiCountOccurrences_150 > 0) {...}\n"},
+        set(), set()
+    '''
+    with open(path, "r") as source:
+        lines = source.readlines()
+
+    loop_sections = dict()
+    loop_edges = dict()
+    hoisted_locks = set()
+    hoisted_unlocks = set()
+    calls = sorted(auto_sync_calls.items(), key=lambda call: get_site_order(call[0]))
+    for idx, (site, func_call) in enumerate(calls[:-1]):
+        update_site, update_call = calls[idx + 1]
+        if func_call[0] != AUTO_SYNC_READ_TO_UPDATE or update_call[0] != AUTO_SYNC_UPDATE or update_call[1] != func_call[1]:
+            continue
+        shared_var = func_call[1]
+        if not (shared_var in mutexes or shared_var in atomic_vars) or "bConstantInitByMain" in intentions.get(shared_var, []) or \
+           site in elided_locks or update_site in elided_unlocks:
+            continue
+
+        # Both calls are whole lines of the same block
+        call_site, update = call_sites[site], call_sites[update_site]
+        block = call_site.ancestors[-1]
+        if not isinstance(block, c_ast.Compound) or update.ancestors[-1] is not block or \
+           not call_site.is_own_line(lines) or not update.is_own_line(lines):
+            continue
+
+        loops = [node for node in call_site.ancestors if isinstance(node, (c_ast.For, c_ast.While, c_ast.DoWhile))]
+        if not loops or isinstance(loops[-1], c_ast.DoWhile) or not isinstance(loops[-1].stmt, c_ast.Compound):
+            continue
+        loop = loops[-1]
+        if any((isinstance(node, c_ast.FuncCall) and node is not call_site.node and node is not update.node) or \
+               isinstance(node, (c_ast.Return, c_ast.Goto)) for node in iter_nodes(loop)):
+            continue
+
+        # The loop is a statement of a block, the code around it is inserted before its first and after its last line.
+        # Only the column of the loop is used, the columns behind it are shifted by the macros the preprocessor expanded
+        offset = call_site.line - call_site.node.coord.line
+        first_line = loop.coord.line + offset
+        end = get_block_end(lines, first_line, loop.coord.column)
+        if not isinstance(call_site.ancestors[call_site.ancestors.index(loop) - 1], c_ast.Compound) or \
+           lines[first_line - 1][:loop.coord.column - 1].strip() or end is None or \
+           re.sub(r"/\*.*?\*/|//.*", "", lines[end[0] - 1][end[1]:]).strip():
+            continue
+        last_line = end[0]
+        loop_indent = lines[first_line - 1][:len(lines[first_line - 1]) - len(lines[first_line - 1].lstrip())]
+
+        body = loop.stmt.block_items or []
+        if shared_var in mutexes and body[0] is call_site.node and body[-1] is update.node:
+            # Every iteration is a critical section, so the mutex is kept locked from the first to the last one
+            loop_edges[first_line] = loop_edges.get(first_line, "") + \
+                lock_shared_var(shared_var, "", mutexes, {}, {}, True)
+            loop_edges[last_line + 1] = loop_edges.get(last_line + 1, "") + \
+                unlock_shared_var(shared_var, "", mutexes, {}, {}, True)
+            hoisted_locks.add(site)
+            hoisted_unlocks.add(update_site)
+            continue
+
+        var_type = shared_var_types.get(shared_var, "")
+        if "bDeferredUpdate" not in intentions.get(shared_var, []) or \
+           not var_type or not all(word in ATOMIC_FETCH_TYPES for word in var_type.split()):
+            continue
+        args = call_site.get_args()
+        if len(args) != 4 or update.get_args()[1] != args[0]:
+            continue
+        local_var = deref_arg(args[0])
+        update_op = get_simple_update(local_var, lines[call_site.line:update.line - 1])
+        if not update_op or not update_op[0] or not re.fullmatch(r"\w+", local_var):
+            continue
+
+        # The local copy does not get the value of the shared-variable anymore, so it must not be used anywhere else
+        if not is_dead_local(call_site, update, local_var):
+            continue
+        decl_line = get_local_decl_line(call_site, local_var, lines)
+
+        operator, operand = update_op
+        if not re.fullmatch(r"\w+", operand):
+            operand = f"({operand})"
+        suffix = f"{c_identifier(shared_var)}_{first_line}"
+        batch = f"xAutoSyncBatch_{suffix}"
+        batched = f"uiAutoSyncBatched_{suffix}"
+        # Subtractions are added up and subtracted at once, an AND starts with all bits set
+        initial = f"({var_type})~({var_type})0" if operator == "&=" else "0"
+
+        def flush(indent: str) -> str:
+            if shared_var in atomic_vars and sync_backend.openmp:
+                return f"{indent}#pragma omp atomic seq_cst\n{indent}{deref_arg(args[1])} {operator} {batch};\n"
+            if shared_var in atomic_vars:
+                return f"{indent}{ATOMIC_FETCH_OPS[operator]}(&{shared_var}, {batch}, memory_order_acq_rel);\n"
+            return lock_shared_var(shared_var, "", mutexes, {}, {}, True) + \
+                   f"{indent}{deref_arg(args[1])} {operator} {batch};\n" + \
+                   unlock_shared_var(shared_var, "", mutexes, {}, {}, True)
+
+        indent = lines[call_site.line - 1][:len(lines[call_site.line - 1]) - len(lines[call_site.line - 1].lstrip())]
+        code = f"{indent}{AUTO_SYNC_GENERATED}"
+        code += f"{indent}{batch} {'+=' if operator == '-=' else operator} {operand};\n"
+        code += f"{indent}if (++{batched} == {batch_size}) {{\n"
+        code += flush(indent + "  ")
+        code += f"{indent}  {batch} = {initial};\n"
+        code += f"{indent}  {batched} = 0;\n"
+        code += f"{indent}}}\n"
+        if decl_line is None:
+            code += f"{indent}(void){local_var};\n"
+        else:
+            # The declaration of the local copy is not needed anymore
+            loop_sections[decl_line] = ""
+        loop_sections[str(call_site.line)] = code
+        for line_no in range(call_site.line + 1, update.line + 1):
+            loop_sections[str(line_no)] = ""
+
+        loop_edges[first_line] = loop_edges.get(first_line, "") + \
+            f"{loop_indent}{AUTO_SYNC_GENERATED}" + \
+            f"{loop_indent}{var_type} {batch} = {initial};\n" + \
+            f"{loop_indent}uint32_t {batched} = 0;\n"
+        loop_edges[last_line + 1] = loop_edges.get(last_line + 1, "") + \
+            f"{loop_indent}{AUTO_SYNC_GENERATED}" + \
+            f"{loop_indent}if ({batched} > 0) {{\n" + \
+            flush(loop_indent + "  ") + \
+            f"{loop_indent}}}\n"
+
+    if hoisted_locks:
+        print(f"!!! [CODE GENERATOR INFO] {len(hoisted_locks)} critical sections locked once around their loop")
+    if loop_sections:
+        print(f"!!! [CODE GENERATOR INFO] {len([code for code in loop_sections.values() if code])} updates batched, applied every {batch_size} updates")
+    return loop_sections, loop_edges, hoisted_locks, hoisted_unlocks
+
+
+def get_combinable_update(local_var: str, body: list, local_names: set) -> tuple:
+    '''
+    Check if the code between a ReadToUpdate/Update pair can run after the update was applied by another thread.
+    Exactly one statement must update the local copy with a simple arithmetic operation whose operand does not
+    change in the pair, the other statements may only assign local variables of the function (e.g. keep the old
+    value). They run again on the old value that the combining thread returns, so they compute the same values.
+    Returns a tuple with the compound operator and the operand, or None if the pair cannot be combined.
+    EXAMPLE:
+        "MyNum = NewId; NewId++;" -> ("+=", "1")
+    '''
+    var = re.escape(local_var)
+    statements = []
+    for line in body:
+        line = re.sub(r"/\*.*?\*/|//.*", "", line).strip()
+        statements += [statement.strip() for statement in line.split(";") if statement.strip()]
+
+    update = None
+    assigned = set()
+    for statement in statements:
+        # Function calls could have side effects outside of the thread (sizeof is evaluated at compile time)
+        if re.search(r"\b(?!sizeof\b)\w+\s*\(", statement):
+            return None
+        if re.fullmatch(r"(\+\+|--)\s*" + var + r"|" + var + r"\s*(\+\+|--)", statement):
+            operation = ("+=" if "++" in statement else "-=", "1")
+        else:
+            match = re.fullmatch(var + r"\s*([-+|&^]=)\s*(.+)", statement)
+            operation = (match.group(1), match.group(2).strip()) if match else None
+        if operation is not None:
+            if update is not None or re.search(r"\b" + var + r"\b|(?<![=!<>])=(?!=)|\+\+|--", operation[1]):
+                return None
+            update = operation
+            continue
+
+        match = re.fullmatch(r"(\w+)\s*(=|[-+*/%&|^]=|<<=|>>=)\s*(.+)", statement)
+        if match is None or match.group(1) == local_var or match.group(1) not in local_names or \
+           re.search(r"(?<![=!<>])=(?!=)|\+\+|--", match.group(3)):
+            return None
+        assigned.add(match.group(1))
+
+    if update is None or assigned & set(re.findall(r"\b\w+\b", update[1])):
+        return None
+    return update
+
+
+def assign_flat_combining(path: str, call_sites: dict, auto_sync_calls: dict, mutexes: dict, intentions: dict, shared_var_types: dict,
+                          mutex_types: dict, reductions: dict, seqlocks: dict, atomic_sections: dict, loop_sections: dict,
+                          elided_locks: set, elided_unlocks: set) -> tuple:
+    '''
+    Logic for applying the ReadToUpdate/Update pairs of contended shared-variables by flat combining. A thread posts
+    the operation of its pair in its publication slot and the thread that gets the mutex of the shared-variable
+    applies all posted operations in one pass, so the shared-variable stays in the cache of one core.
+    The mutex stays the lock of the shared-variable, the other accesses still lock it.
+    Only pairs of integer shared-variables whose code is combinable (see get_combinable_update) are combined, the
+    shared-variables lowered to atomics, with sequence locks, recursive mutexes or reductions are not.
+    Returns the generated code for the lines of the combined pairs and a dictionary with the type of the values
+    and the mutex of every combined shared-variable.
+    EXAMPLE:
+        {"648": "NewId = xAutoSyncCombine_Global_id((long*)(&Global->id), '+', 1);\n", "651": ""},
+        {"Global->id": ("long", "xMutex_Global_id")}
+    '''
+    with open(path, "r") as source:
+        lines = source.readlines()
+
+    combine_sections = dict()
+    combined = dict()
+    calls = sorted(auto_sync_calls.items(), key=lambda call: get_site_order(call[0]))
+    for idx, (site, func_call) in enumerate(calls[:-1]):
+        update_site, update_call = calls[idx + 1]
+        if func_call[0] != AUTO_SYNC_READ_TO_UPDATE or update_call[0] != AUTO_SYNC_UPDATE or update_call[1] != func_call[1]:
+            continue
+        shared_var = func_call[1]
+        call_site, update = call_sites[site], call_sites[update_site]
+        if shared_var not in mutexes or shared_var in reductions or shared_var in seqlocks or \
+           mutex_types.get(mutexes[shared_var], MUTEX_RECURSIVE) == MUTEX_RECURSIVE or \
+           "bConstantInitByMain" in intentions.get(shared_var, []) or \
+           site in elided_locks or update_site in elided_unlocks or \
+           str(call_site.line) in loop_sections or str(call_site.line) in atomic_sections or \
+           not call_site.is_own_line(lines) or not update.is_own_line(lines) or update.ancestors[-1] is not call_site.ancestors[-1]:
+            continue
+
+        args = call_site.get_args()
+        if len(args) != 4 or update.get_args()[1] != args[0] or not re.fullmatch(r"&\s*\w+", args[0]):
+            continue
+        local_var = deref_arg(args[0])
+
+        # The local copy gets the value returned by the combine function, so it has the type of the shared-variable.
+        # The type of members is not known, the pair copies the size of the local copy then
+        func_def = next(node for node in call_site.ancestors if isinstance(node, c_ast.FuncDef))
+        decls = [node for node in iter_nodes(func_def) if isinstance(node, c_ast.Decl) and node.name]
+        var_type = next((" ".join(decl.type.type.names) for decl in decls if decl.name == local_var and \
+                         isinstance(decl.type, c_ast.TypeDecl) and isinstance(decl.type.type, c_ast.IdentifierType)), "")
+        if not var_type or not all(word in ATOMIC_INTEGER_TYPES for word in var_type.split()) or \
+           shared_var_types.get(shared_var, var_type) != var_type or \
+           re.sub(r"\s", "", args[2]) not in [f"sizeof({local_var})", f"sizeof({var_type.replace(' ', '')})"] or \
+           combined.get(shared_var, (var_type,))[0] != var_type:
+            continue
+
+        update_op = get_combinable_update(local_var, lines[call_site.line:update.line - 1], {decl.name for decl in decls})
+        if update_op is None:
+            continue
+        operator, operand = update_op
+
+        line = lines[call_site.line - 1]
+        indent = line[:len(line) - len(line.lstrip())]
+        # The code of the pair runs on the old value, it computes the new value and the other locals again
+        combine_sections[str(call_site.line)] = f"{indent}{AUTO_SYNC_GENERATED}" + \
+            f"{indent}{local_var} = xAutoSyncCombine_{c_identifier(shared_var)}(({var_type}*)({args[1]}), '{operator[0]}', {operand});\n"
+        combine_sections[str(update.line)] = ""
+        combined[shared_var] = (var_type, mutexes[shared_var])
+
+    if combine_sections:
+        print(f"!!! [CODE GENERATOR INFO] {len(combine_sections) // 2} ReadToUpdate/Update pairs of {sorted(combined)} are flat-combined")
+    return combine_sections, combined
+
+
+def assign_critical_sections(call_sites: dict, auto_sync_calls: dict, mutexes: dict, intentions: dict, mutex_types: dict, reductions: dict,
+                             atomic_sections: dict, loop_sections: dict, hoisted_locks: set, elided_locks: set, elided_unlocks: set,
+                             combined: dict, profile: bool) -> set:
+    '''
+    Logic for lowering the critical sections of mutexes to named OpenMP critical regions (OpenMP backend only).
+    A critical region is a block, so every lock of the mutex must be closed by its unlock in the same block: a
+    Read/Write locks and unlocks itself, a ReadToUpdate/Update pair must be two statements of the same block without
+    a jump in between. Critical regions are not recursive, so the mutex must never be locked twice by a thread.
+    The mutexes of reductions and flat-combined shared-variables are locked by _AutoSync.c, profiled locks need a
+    try-lock and the locks around loops and of batched updates were already generated, they stay OpenMP locks.
+    Returns the mutexes whose critical sections are critical regions.
+    EXAMPLE:
+        {"xMutex_Global_finishtime", "xMutex_Global_initdonetime"}
+    '''
+    if not sync_backend.openmp or profile:
+        return set()
+
+    critical_mutexes = {mutex for mutex in mutexes.values() if mutex_types.get(mutex, MUTEX_RECURSIVE) != MUTEX_RECURSIVE}
+    critical_mutexes -= {mutexes[shared_var] for shared_var in reductions if shared_var in mutexes}
+    critical_mutexes -= {mutex for var_type, mutex in combined.values()}
+
+    calls = sorted(auto_sync_calls.items(), key=lambda call: get_site_order(call[0]))
+    for idx, (site, func_call) in enumerate(calls):
+        if func_call[0] not in [AUTO_SYNC_READ, AUTO_SYNC_WRITE, AUTO_SYNC_READ_TO_UPDATE, AUTO_SYNC_UPDATE] or func_call[1] not in mutexes:
+            continue
+        shared_var = func_call[1]
+        mutex = mutexes[shared_var]
+        call_site = call_sites[site]
+        if site in hoisted_locks or str(call_site.line) in loop_sections:
+            # Locked around its loop or by the flush of its batch with an OpenMP lock
+            critical_mutexes.discard(mutex)
+            continue
+        if "bConstantInitByMain" in intentions.get(shared_var, []) or str(call_site.line) in atomic_sections:
+            continue
+
+        locked = site not in elided_locks
+        if func_call[0] in [AUTO_SYNC_READ, AUTO_SYNC_WRITE]:
+            # A coalesced critical section spans several calls
+            if locked != (site not in elided_unlocks):
+                critical_mutexes.discard(mutex)
+            continue
+        if func_call[0] == AUTO_SYNC_UPDATE:
+            # Closed by the check of its ReadToUpdate
+            if idx == 0 or calls[idx - 1][1][0] != AUTO_SYNC_READ_TO_UPDATE or calls[idx - 1][1][1] != shared_var:
+                critical_mutexes.discard(mutex)
+            continue
+
+        if idx + 1 == len(calls) or calls[idx + 1][1][0] != AUTO_SYNC_UPDATE or calls[idx + 1][1][1] != shared_var:
+            critical_mutexes.discard(mutex)
+            continue
+        update_site = calls[idx + 1][0]
+        update = call_sites[update_site]
+        if locked != (update_site not in elided_unlocks):
+            critical_mutexes.discard(mutex)
+            continue
+        if not locked:
+            continue
+
+        block = call_site.ancestors[-1]
+        if not isinstance(block, c_ast.Compound) or update.ancestors[-1] is not block or not call_site.braced or not update.braced:
+            critical_mutexes.discard(mutex)
+            continue
+        items = block.block_items
+        between = items[items.index(call_site.node) + 1:items.index(update.node)]
+        if any(isinstance(node, (c_ast.Return, c_ast.Goto, c_ast.Break, c_ast.Continue, c_ast.Label)) \
+               for item in between for node in iter_nodes(item)):
+            critical_mutexes.discard(mutex)
+
+    if critical_mutexes:
+        print(f"!!! [CODE GENERATOR INFO] {len(critical_mutexes)} mutexes lowered to OpenMP critical regions")
+    return critical_mutexes
+
+
+def assign_reductions(auto_sync_calls: dict, shared_var_types: dict) -> dict:
+    '''
+    Logic for assigning the operation and the type of the per-thread accumulators to the reduced shared-variables.
+    The type is empty if it is not known by the parser. In this case, the reduction is combined directly under the mutex.
+    Returns a dictionary where every reduced shared-variable is a key and has its associated type and operation.
+    EXAMPLE:
+        "uiCountOccurrences": ("uint32_t", "AUTO_SYNC_SUM")
+    '''
+    reductions = dict()
+    for line, func_call in auto_sync_calls.items():
+        if func_call[0] == AUTO_SYNC_REDUCE:
+            shared_var = func_call[1]
+            reduce_op = func_call[2]
+
+            if reduce_op not in REDUCE_OPS:
+                print(f'[CODE GENERATOR ERROR] Unknown reduction operation {reduce_op} in line {line}')
+                exit(1)
+            if shared_var in reductions and reductions[shared_var][1] != reduce_op:
+                print(f'[CODE GENERATOR ERROR] Shared-variable {shared_var} is reduced with conflicting operations!')
+                exit(1)
+
+            reductions[shared_var] = (shared_var_types.get(shared_var, ""), reduce_op)
+
+    pprint.pprint(reductions)
+    return reductions
+
+
+def assign_reduce_events(threads_info: dict, call_graph: dict, auto_sync_calls: dict, reductions: dict) -> dict:
+    '''
+    Logic for choosing the events where the per-thread accumulators of the reductions are combined. A reduction is
+    combined at an event if a thread that reduces it, directly or through its callees, proceeds on the event. All
+    the threads of the event take part in the combine, so it is emitted at every call of the event.
+    Returns a dictionary where every event is a key and has its combined shared-variables.
+    EXAMPLE:
+        "xStep": ["uiSum"]
+    '''
+    # Functions reachable from every function through the call graph
+    reachable = {func: {func} for func in call_graph}
+    changed = True
+    while changed:
+        changed = False
+        for func, calls in call_graph.items():
+            for line_no, callee in calls:
+                if callee in reachable and not reachable[callee] <= reachable[func]:
+                    reachable[func] |= reachable[callee]
+                    changed = True
+
+    events_of_line = dict()
+    for site, func_call in auto_sync_calls.items():
+        if func_call[0] == AUTO_SYNC_PROCEED_ON_EVENT:
+            events_of_line.setdefault(get_site_line(site), []).append(func_call[1])
+
+    reduce_events = dict()
+    for thread, info in threads_info.items():
+        if info["Quantity"] == 0:
+            continue
+        funcs = reachable.get(thread, {thread})
+        reduced = [shared_var for func in funcs for shared_var in threads_info.get(func, {}).get("Reduce", [])
+                   if shared_var in get_typed_reductions(reductions)]
+        events = [event for func in funcs for line_no, callee in call_graph.get(func, [])
+                  if callee == AUTO_SYNC_PROCEED_ON_EVENT for event in events_of_line.get(line_no, [])]
+        for event in events:
+            reduce_events[event] = del_duplicates(reduce_events.get(event, []) + reduced)
+
+    reduce_events = {event: sorted(shared_vars) for event, shared_vars in reduce_events.items() if shared_vars}
+    pprint.pprint(reduce_events)
+    return reduce_events
+
+
+def get_combine_events(reduce_events: dict) -> dict:
+    '''
+    Get the events where every reduced shared-variable is combined, the inverse of assign_reduce_events
+    '''
+    combine_events = dict()
+    for event, shared_vars in sorted(reduce_events.items()):
+        for shared_var in shared_vars:
+            combine_events.setdefault(shared_var, []).append(event)
+    return combine_events
+
+
+def assign_queues(queues: dict, intentions: dict, shared_var_types: dict) -> dict:
+    '''
+    Logic for choosing the ring buffer of every queue. A queue with a single producer and a single consumer only
+    needs the loads and stores of its indices, the other ones need the per-slot sequence numbers of Vyukov's
+    bounded MPMC queue. A thread count that the parser could not constant-fold is only single if the intention
+    says so. The capacity is given by the intention or is the size of the array of the queue.
+    Returns a dictionary where every queue is a key and has its capacity and its ring buffer.
+    EXAMPLE:
+        "xWorkQueue": (16, "SPSC")
+    '''
+    assigned_queues = dict()
+    for queue, queue_info in queues.items():
+        capacity = queue_info["Capacity"]
+        if not capacity:
+            # The array of the queue is declared as "xWorkQueue[16]"
+            sizes = [int(var[len(queue) + 1:-1]) for var in shared_var_types if re.fullmatch(rf"{re.escape(queue)}\[\d+\]", var)]
+            capacity = sizes[0] if sizes else 0
+        if capacity < 2 or capacity & (capacity - 1):
+            print(f"[CODE GENERATOR ERROR] Capacity of queue {queue} has to be a power of two of at least 2, set uiQueueCapacity in its intention")
+            exit(1)
+
+        single = []
+        for end, flag in [("Producers", "bSingleProducer"), ("Consumers", "bSingleConsumer")]:
+            if isinstance(queue_info[end], int) and queue_info[end] > 1 and flag in intentions.get(queue, []):
+                print(f"[CODE GENERATOR ERROR] Queue {queue} has the intention {flag} but {queue_info[end]} threads use it")
+                exit(1)
+            single.append(queue_info[end] == 1 or flag in intentions.get(queue, []))
+
+        assigned_queues[queue] = (capacity, QUEUE_SPSC if all(single) else QUEUE_MPMC)
+        print(f"!!! [CODE GENERATOR INFO] Queue {queue}: {assigned_queues[queue][1]} ring buffer of {capacity} items " + \
+              f"({queue_info['Producers']} producers, {queue_info['Consumers']} consumers)")
+
+    return assigned_queues
+
+
+def is_same_c_expression(expr: object, other: object) -> bool:
+    '''
+    Check if two quantities of threads are the same C expression, apart from spaces and enclosing parentheses.
+    EXAMPLE:
+        "(P)", "P" -> True
+    '''
+    def strip(expr: object) -> str:
+        expr = re.sub(r"\s+", "", str(expr))
+        while expr.startswith("(") and expr.endswith(")"):
+            depth = 0
+            for idx, char in enumerate(expr):
+                depth += 1 if char == "(" else -1 if char == ")" else 0
+                if depth == 0 and idx < len(expr) - 1:
+                    return expr
+            expr = expr[1:-1]
+        return expr
+    return strip(expr) == strip(other)
+
+
+def assign_event_sync_mechanisms(auto_sync_calls: dict, event_barriers: dict, team: object = None) -> dict:
+    '''
+    Logic for assigning mutexes, condition variables and the barrier algorithm to the events.
+    With the OpenMP backend, the events that all threads of the parallel region (team) proceed on are OpenMP barriers.
+    Returns a dictionary where every event is a key and has its associated mutex, conditon variable, counter,
+    generation and barrier algorithm. The mutex, condition variable, counter and generation are only used by 
+    the default barrier.
+    EXAMPLE:
+        "TransposeDone": ["xMutex_TransposeDone", "xCondVar_TransposeDone", "uiCounter_TransposeDone", 
+                          "uiGeneration_TransposeDone", "AUTO_SYNC_BARRIER_DEFAULT"]
     '''
     MUTEX_NAME = "xMutex__DUMMY__"
     COND_VAR_NAME = "xCondVar__DUMMY__"
     COUNTER_VAR_NAME = "uiCounter__DUMMY__"
+    GENERATION_VAR_NAME = "uiGeneration__DUMMY__"
 
     sync_mechanisms = dict()
+    # The backends without condition variables replace the default barrier by their own
+    barriers = {event: sync_backend.default_barrier if barrier == AUTO_SYNC_BARRIER_DEFAULT else barrier
+                for event, barrier in event_barriers.items()}
+    if team is not None:
+        events = {func_call[1] for func_call in auto_sync_calls.values() if func_call[0] == AUTO_SYNC_PROCEED_ON_EVENT}
+        for event in events:
+            if all(is_same_c_expression(func_call[2], team) for func_call in auto_sync_calls.values() \
+                   if func_call[0] == AUTO_SYNC_PROCEED_ON_EVENT and func_call[1] == event):
+                barriers[event] = AUTO_SYNC_BARRIER_OMP
+            else:
+                print(f"!!! [CODE GENERATOR INFO] Not all threads of the parallel region proceed on {event}, it keeps a barrier of AutoSync")
     # Iterate through all calls to get the ones that contains xAutoSyncEvent as argument
     # Example: "925": ["iAutoSyncProceedOnCondition", "xFFTDone", "P"]
     for line, func_call in auto_sync_calls.items():
@@ -434,41 +3777,150 @@ def assign_event_sync_mechanisms(auto_sync_calls: dict) -> dict:
             event = func_call[1]
             sync_mechanisms[event] = (MUTEX_NAME.replace("_DUMMY__", event), \
                                       COND_VAR_NAME.replace("_DUMMY__", event), \
-                                      COUNTER_VAR_NAME.replace("_DUMMY__", event))   
+                                      COUNTER_VAR_NAME.replace("_DUMMY__", event), \
+                                      GENERATION_VAR_NAME.replace("_DUMMY__", event), \
+                                      barriers.get(event, sync_backend.default_barrier))
     
     pprint.pprint(sync_mechanisms)
     return sync_mechanisms
 
 if __name__ == "__main__":
+    arg_parser = argparse.ArgumentParser(description="Generate the synchronization of a C file parsed by parser_auto_sync.py")
+    arg_parser.add_argument("paths", nargs="+", help="C files that were parsed, in the same order")
+    arg_parser.add_argument("--layout", choices=[LAYOUT_PACKED, LAYOUT_ALIGNED, LAYOUT_COLOCATED], default=LAYOUT_PACKED,
+                            help="Memory layout of the generated locks")
+    arg_parser.add_argument("--cost-model", action="store_true",
+                            help="Split the locks at constant shared-variables if the threads contend for them and report the expected contention per lock")
+    arg_parser.add_argument("--profile-locks", action="store_true",
+                            help="Count the acquisitions, contention, wait and hold time of every lock site, dumped by iAutoSyncDestroy")
+    arg_parser.add_argument("--lock-profile", metavar="JSON",
+                            help="Lock profile of a run with --profile-locks, used to choose the lock of every shared-variable")
+    arg_parser.add_argument("--batch-size", type=int, default=BATCH_SIZE,
+                            help="Updates combined in a loop before they are applied, for shared-variables with the intention bDeferredUpdate")
+    arg_parser.add_argument("--flat-combining", action="store_true",
+                            help="Let the thread with the mutex apply the pending updates of all threads, for contended shared-variables that are not atomics")
+    arg_parser.add_argument("--backend", choices=list(SYNC_BACKENDS), default=BACKEND_PTHREAD,
+                            help="Library of the generated locks and barriers, openmp also runs the threads of main in a parallel region")
+    args = arg_parser.parse_args()
+    sync_backend = SYNC_BACKENDS[args.backend]
     
     # Open result file from parser and extract info
-    threads_info, shared_var_types, auto_sync_calls, dependencies, intentions = get_info_from_parser("../05_Workspace/parser_out.json") 
+    threads_info, shared_var_types, auto_sync_calls, dependencies, intentions, event_barriers, sliced_arrays, array_indexes, call_graph, global_vars, single_threaded_sites, units, queues = get_info_from_parser("../05_Workspace/parser_out.json") 
+
+    # The translation units are one source with the lines of the parser
+    source_path, outputs = get_source_of_units(args.paths, units)
+    # Older parsers only give the line of a call of a single-threaded site
+    single_threaded_sites = {str(site) for site in single_threaded_sites}
+
+    # Every AutoSync call in the AST of its translation unit, with the source range that is replaced
+    call_sites = get_call_sites(units if units is not None else [[args.paths[0], 0]], auto_sync_calls)
+
+    # Assign per-thread accumulators to the reduced shared-variables
+    reductions = assign_reductions(auto_sync_calls, shared_var_types)
+    reduce_events = assign_reduce_events(threads_info, call_graph, auto_sync_calls, reductions)
+
+    # The OpenMP backend runs the threads of main in a parallel region, the events of the whole region are its barriers
+    thread_sections, team = dict(), None
+    if sync_backend.openmp:
+        thread_sections, thread_func = assign_parallel_region(units if units is not None else [[args.paths[0], 0]], source_path, reductions)
+        team = threads_info[thread_func]["Quantity"] if thread_func in threads_info else None
 
     # Assign sync_mechanisms for the interface methods with events
-    event_sync_mechanisms = assign_event_sync_mechanisms(auto_sync_calls)    
-    events_mutexes = del_duplicates([sync_mech[0] for sync_mech in event_sync_mechanisms.values()])
-    events_cond_var = del_duplicates([sync_mech[1] for sync_mech in event_sync_mechanisms.values()])
-    events_counter_var = del_duplicates([sync_mech[2] for sync_mech in event_sync_mechanisms.values()])
+    # Only the events with the default barrier need a mutex, a condition variable and counters
+    event_sync_mechanisms = assign_event_sync_mechanisms(auto_sync_calls, event_barriers, team)
+    default_sync_mechanisms = [sync_mech for sync_mech in event_sync_mechanisms.values() if sync_mech[4] == AUTO_SYNC_BARRIER_DEFAULT]
+    events_mutexes = del_duplicates([sync_mech[0] for sync_mech in default_sync_mechanisms])
+    events_cond_var = del_duplicates([sync_mech[1] for sync_mech in default_sync_mechanisms])
+    events_counter_var = del_duplicates([sync_mech[2] for sync_mech in default_sync_mechanisms] + \
+                                        [sync_mech[3] for sync_mech in default_sync_mechanisms])
    
+    # Shared-variables published once by main before the threads are created are as constant as the ones
+    # initialized by main: pthread_create already orders the writes before the reads of the threads
+    for shared_var, var_intentions in intentions.items():
+        if "bPublishedOnce" in var_intentions and "bConstantInitByMain" not in var_intentions:
+            var_intentions.append("bConstantInitByMain")
+
     # Assign mutexes to the shared-variables based on the intentions
-    mutexes = assign_mutexes(dependencies)
+    mutexes = assign_mutexes(dependencies, intentions, threads_info, args.cost_model)
+
+    # Queues are lock-free ring buffers, they do not need a mutex
+    queues = assign_queues(queues, intentions, shared_var_types)
+    for queue in queues:
+        del mutexes[queue]
     
     existing_threads = list(threads_info.keys())
     existing_shared_var = list(mutexes.keys())
+
+    # Sliced arrays are protected by one mutex per slice or not locked at all if the slices are disjoint
+    sliced_arrays = assign_sliced_arrays(sliced_arrays, mutexes, intentions)
+    for shared_var in sliced_arrays:
+        del mutexes[shared_var]
+
+    # Lower scalar shared-variables with simple updates to C11 atomics, their mutexes are not needed anymore
+    atomic_vars, atomic_sections = assign_atomic_updates(source_path, call_sites, auto_sync_calls, mutexes, intentions, shared_var_types)
+    for shared_var in atomic_vars:
+        del mutexes[shared_var]
+
+    # Shared-variables with the intention bOptimisticRead are read with sequence locks, only the writers lock
+    seqlocks = assign_seqlocks(intentions, mutexes, reductions)
+
+    # Read-mostly shared-variables are protected by reader-writer locks instead of mutexes, or the contended ones if
+    # there is a lock profile
+    lock_profile = get_lock_profile(args.lock_profile, auto_sync_calls) if args.lock_profile else None
+    rwlocks = assign_rwlocks(threads_info, auto_sync_calls, mutexes, intentions, reductions, seqlocks, lock_profile)
+    for shared_var in rwlocks:
+        del mutexes[shared_var]
+
+    # Mutexes that protect a single global shared-variable are placed next to it
+    colocated, colocated_decls = assign_colocations(source_path, global_vars, mutexes, intentions, args.layout)
+
+    # Mutexes are only recursive if a thread could lock them twice
+    mutex_types = assign_mutex_types(call_graph, auto_sync_calls, mutexes, intentions, sliced_arrays, seqlocks, reductions, reduce_events, events_mutexes)
+    if args.cost_model:
+        report_lock_contention(threads_info, mutexes, rwlocks, intentions)
     
+    # Consecutive calls that take the same lock share one critical section
+    elided_locks, elided_unlocks = assign_coalesced_sections(source_path, call_sites, auto_sync_calls, mutexes, intentions, atomic_sections,
+                                                             sliced_arrays, array_indexes, rwlocks, seqlocks, single_threaded_sites)
+
+    # Calls that only run while main is the only thread are plain copies
+    elided_locks |= single_threaded_sites
+    elided_unlocks |= single_threaded_sites
+
+    # Critical sections of updates in tight loops are locked once around the loop or batched
+    loop_sections, loop_edges, hoisted_locks, hoisted_unlocks = assign_loop_batches(source_path, call_sites, auto_sync_calls, mutexes, intentions, atomic_vars,
+                                                                                    shared_var_types, elided_locks, elided_unlocks, args.batch_size)
+    elided_locks |= hoisted_locks
+    elided_unlocks |= hoisted_unlocks
+
+    # The updates of contended shared-variables can be applied by the thread that holds the mutex
+    combine_sections, combined = dict(), dict()
+    if args.flat_combining:
+        combine_sections, combined = assign_flat_combining(source_path, call_sites, auto_sync_calls, mutexes, intentions, shared_var_types, mutex_types,
+                                                           reductions, seqlocks, atomic_sections, loop_sections, elided_locks, elided_unlocks)
+
+    # With the OpenMP backend, the critical sections that are blocks are named critical regions
+    sync_backend.critical_mutexes = assign_critical_sections(call_sites, auto_sync_calls, mutexes, intentions, mutex_types, reductions,
+                                                             atomic_sections, loop_sections, hoisted_locks, elided_locks, elided_unlocks, combined,
+                                                             args.profile_locks)
+
     # Create new source file replacing auto_sync calls in the original file
-    replace_auto_sync_calls(sys.argv[1], auto_sync_calls, mutexes, intentions, event_sync_mechanisms)
+    profile_sites = replace_auto_sync_calls(source_path, call_sites, auto_sync_calls, mutexes, intentions, event_sync_mechanisms, atomic_sections, reductions, reduce_events, sliced_arrays, array_indexes, rwlocks, seqlocks, colocated_decls, elided_locks, elided_unlocks, loop_sections, loop_edges, thread_sections, combine_sections, args.profile_locks, outputs)
                 
     # Generate header file
     # Eliminate duplicated calls because we only need to declare it once
     auto_sync_unique_calls = list(set(map(lambda i: tuple(sorted(i)), [item[1] for item in auto_sync_calls.items()])))
-    create_auto_sync_header(events_counter_var, events_mutexes, events_cond_var, auto_sync_unique_calls, mutexes)
+    # The per-thread arrays only need a slot for every thread if the quantity of threads is constant
+    max_threads = get_max_threads(threads_info)
+    if max_threads is not None:
+        print(f"!!! [CODE GENERATOR INFO] The per-thread arrays are sized for {max_threads} threads")
+    create_auto_sync_header(events_counter_var, events_mutexes, events_cond_var, auto_sync_unique_calls, mutexes, atomic_vars, reductions, reduce_events, event_sync_mechanisms, sliced_arrays, rwlocks, seqlocks, queues, combined, colocated, args.layout, profile_sites, max_threads)
     
     # Create _AutoSync.c
-    create_auto_sync_impl(events_mutexes, events_cond_var, mutexes, existing_shared_var, auto_sync_unique_calls)
+    create_auto_sync_impl(events_mutexes, events_cond_var, mutexes, existing_shared_var, auto_sync_unique_calls, reductions, reduce_events, event_sync_mechanisms, sliced_arrays, rwlocks, mutex_types, queues, combined, profile_sites)
 
     # Print success message
-    print(f'Code generation was successful! Please see the file \"../05_Workspace/temp.c\"')
+    print(f'Code generation was successful! Please see the files {list(outputs.values())}')
    
 
   
@@ -3,6 +3,11 @@ import platform
 import sys
 import json
 import pprint
+import re
+import os
+import argparse
+import hashlib
+import multiprocessing
 from collections.abc import Iterable
 
 sys.path.insert(0,'../pycparser')
@@ -14,22 +19,38 @@ sys.path.insert(0,'../pycparser/utils/')
 #
 sys.path.extend(['.', '..', '../pycparser/pycparser'])
 
-from pycparser import c_ast, parse_file
+from pycparser import c_ast, c_generator, parse_file
 from IPython import embed
 
 FUNC_CREATE_TASK = "pthread_create"
+FUNC_JOIN_TASK = "pthread_join"
+FUNC_DETACH_TASK = "pthread_detach"
 READ_SHARED_VAR  = "iAutoSyncRead"
 WRITE_SHARED_VAR = "iAutoSyncWrite"
 READ_TO_UPDATE_SHARED_VAR = "iAutoSyncReadToUpdate"
 UPDATE_SHARED_VAR = "iAutoSyncUpdate"
+REDUCE_SHARED_VAR = "iAutoSyncReduce"
+ENQUEUE = "iAutoSyncEnqueue"
+DEQUEUE = "iAutoSyncDequeue"
 PROCEED_ON_EVENT = "iAutoSyncProceedOnEvent"
+EVENT_TYPE = "xAutoSyncEvent"
+INTENTIONS_TYPE = "xAutoSyncIntentions"
+BARRIER_DEFAULT = "AUTO_SYNC_BARRIER_DEFAULT"
                      
 PATH_JSON = "../05_Workspace/parser_out.json"
+# Summaries of the translation units, named after the hash of their content
+PATH_CACHE = "../05_Workspace/cache"
 
 shared_var_usage = {}
 auto_sync_calls = {}
+event_barriers = {}
+sliced_arrays = {}
+array_indexes = {}
+thread_ids = {}
+call_graph = {}
 intentions = {}           # ToDo: this should be called shared_var_dependencies
 general_intentions = {}   # ToDo: this should be called intentions
+queues = {}
 
 ########################################################################
 ##                       HELPER FUNCTIONS                             ##
@@ -53,10 +74,13 @@ def del_duplicates(lis: list) -> list:
 def get_shared_var_from_auto_sync_call(node: c_ast.Node) -> str:
     # arg_pos is the position of the shared-variable in the AutoSync function signature
     if node.name.name == READ_SHARED_VAR or \
-       node.name.name == READ_TO_UPDATE_SHARED_VAR:   
+       node.name.name == READ_TO_UPDATE_SHARED_VAR or \
+       node.name.name == DEQUEUE:
        arg_pos = 1 
     elif node.name.name == WRITE_SHARED_VAR or \
-        node.name.name == UPDATE_SHARED_VAR:
+        node.name.name == UPDATE_SHARED_VAR or \
+        node.name.name == REDUCE_SHARED_VAR or \
+        node.name.name == ENQUEUE:
         arg_pos = 0
     else:
         return ""
@@ -96,382 +120,838 @@ def get_shared_var_from_auto_sync_call(node: c_ast.Node) -> str:
         exit(1)        
 
 
-# Get all the existing threads 
-class ThreadCreationVisitor(c_ast.NodeVisitor):
-    def __init__(self):        
-        # main should always exist and is not created with pthread_create
-        self.existing_threads = ['main']
-
-    def visit_FuncCall(self, node):
-        if node.name.name == FUNC_CREATE_TASK:
-            thread = node.args.exprs[2].expr.name
-            self.existing_threads.append(thread)        
-
-        # Visit args in case they contain more func calls.
-        if node.args:
-            self.visit(node.args)
-
-    def get_existing_threads(self):
-        return self.existing_threads
-
-    def show(self):
-        print(self.existing_threads)
-
-
-# Get the quantity of each existing thread
-class NoOfThreadsVisitor(c_ast.NodeVisitor):
-    def __init__(self, existing_threads):
-        self.existing_threads = existing_threads
-        self.no_of_threads = {}
-        self.no_of_threads_outside_loop()
-
-
-    def no_of_threads_outside_loop(self):
-        for thread in self.existing_threads:
-            self.no_of_threads[thread] = self.existing_threads.count(thread)
-
+def get_array_index_from_auto_sync_call(node: c_ast.Node) -> str:
+    '''
+    Get the index of the element accessed by an AutoSync call.
+    Returns an empty string if the whole shared-variable is accessed.
+    EXAMPLE:
+        iAutoSyncWrite(&Global->transtimes[MyNum], ...) -> "MyNum"
+    '''
+    if node.name.name == READ_SHARED_VAR or \
+       node.name.name == READ_TO_UPDATE_SHARED_VAR:
+        arg_pos = 1
+    else:
+        arg_pos = 0
 
-    def visit_For(self, node):
-        if FUNC_CREATE_TASK in node.stmt.show.__str__():
-            for thread in self.existing_threads:
-                if thread in node.stmt.show.__str__():
-                    self.no_of_threads[thread] += 1  
-    
+    arg = node.args.exprs[arg_pos]
+    if isinstance(arg, c_ast.UnaryOp) and arg.op == '&' and isinstance(arg.expr, c_ast.ArrayRef):
+        return c_generator.CGenerator().visit(arg.expr.subscript)
+    return ""
 
-    def visit_While(self, node):
-        if FUNC_CREATE_TASK in node.stmt.show.__str__():
-            for thread in self.existing_threads:
-                if thread in node.stmt.show.__str__():
-                    self.no_of_threads[thread] += 1
 
-    def get_no_of_threads(self):      
-        return self.no_of_threads
+def get_site_line(site) -> int:
+    '''
+    Get the line of an AutoSync call. A call is identified by its line, the following calls of the same line by their
+    line and column.
+    EXAMPLE:
+        "104:37" -> 104
+    '''
+    return int(str(site).split(":")[0])
 
 
-    def show(self):
-        print(self.no_of_threads)
+def get_site_order(site) -> tuple:
+    # The call identified by its line is the first one of the line
+    line_no, _, column = str(site).partition(":")
+    return (int(line_no), int(column or 0))
 
 
-# Get the existing shared-variables 
-class SharedVarVisitor(c_ast.NodeVisitor):
-    def __init__(self):        
-        self.existing_shared_var = []
+def shift_site(site, offset: int) -> str:
+    line_no, _, column = str(site).partition(":")
+    return f"{int(line_no) + offset}:{column}" if column else str(int(line_no) + offset)
 
 
-    def visit_FuncCall(self, node):        
-        self.existing_shared_var.append(get_shared_var_from_auto_sync_call(node))
+def get_reachable(funcs: set, call_graph: dict, excluded: set = set()) -> set:
+    '''
+    Get the functions that run when the functions are called: the functions and all the functions they call.
+    The excluded functions and the functions only they call are not followed.
+    '''
+    reachable = set(funcs)
+    pending = list(funcs)
+    while pending:
+        for line_no, callee in call_graph.get(pending.pop(), []):
+            if callee not in reachable and callee not in excluded:
+                reachable.add(callee)
+                pending.append(callee)
+    return reachable
+
+
+def get_constant_value(node: c_ast.Node) -> int:
+    # Remove the suffixes of integer constants (e.g. 10UL)
+    if not isinstance(node, c_ast.Constant):
+        print(f'[PARSE ERROR] Intention is not an integer constant: {node}')
+        exit(1)
+    return int(re.sub(r"[uUlL]+$", "", node.value), 0)
 
-        # Visit args in case they contain more func calls.
-        if node.args:
-            self.visit(node.args)
 
+def fold_linear(node: c_ast.Node) -> tuple:
+    '''
+    Constant-fold an integer expression into a linear form: the runtime values it depends on, each with its factor,
+    and a constant. Macros are already expanded by the preprocessor. Sub-expressions that are not linear (e.g. a 
+    product of two runtime values) are kept as one runtime value.
+    EXAMPLE:
+        (P) - 1 -> ({"P": 1}, -1)
+    '''
+    if isinstance(node, c_ast.Constant) and re.fullmatch(r"(0[xX][0-9a-fA-F]+|[0-9]+)[uUlL]*", node.value):
+        value = re.sub(r"[uUlL]+$", "", node.value)
+        # Integer constants with a leading 0 are octal in C
+        return ({}, int(value, 8) if re.fullmatch(r"0[0-7]+", value) else int(value, 0))
+    if isinstance(node, c_ast.ID):
+        return ({node.name: 1}, 0)
+    if isinstance(node, c_ast.Cast):
+        return fold_linear(node.expr)
+    if isinstance(node, c_ast.UnaryOp) and node.op in ['+', '-']:
+        return scale_linear(fold_linear(node.expr), -1 if node.op == '-' else 1)
+    if isinstance(node, c_ast.BinaryOp) and node.op in ['+', '-']:
+        return add_linear(fold_linear(node.left), fold_linear(node.right), -1 if node.op == '-' else 1)
+    if isinstance(node, c_ast.BinaryOp) and node.op == '*':
+        return mul_linear(fold_linear(node.left), fold_linear(node.right))
+    if isinstance(node, c_ast.BinaryOp) and node.op == '/':
+        left, right = fold_linear(node.left), fold_linear(node.right)
+        if not left[0] and not right[0] and right[1] != 0:
+            # C truncates towards zero
+            return ({}, int(left[1] / right[1]))
+    return ({f"({c_generator.CGenerator().visit(node)})": 1}, 0)
+
+
+def add_linear(a: tuple, b: tuple, sign: int = 1) -> tuple:
+    terms = dict(a[0])
+    for term, factor in b[0].items():
+        terms[term] = terms.get(term, 0) + sign * factor
+        if terms[term] == 0:
+            del terms[term]
+    return (terms, a[1] + sign * b[1])
+
+
+def scale_linear(a: tuple, factor: int) -> tuple:
+    if factor == 0:
+        return ({}, 0)
+    return ({term: factor * term_factor for term, term_factor in a[0].items()}, factor * a[1])
+
+
+def mul_linear(a: tuple, b: tuple) -> tuple:
+    if not a[0]:
+        return scale_linear(b, a[1])
+    if not b[0]:
+        return scale_linear(a, b[1])
+    return ({f"({linear_to_c(a)}) * ({linear_to_c(b)})": 1}, 0)
+
+
+def linear_to_c(a: tuple):
+    '''
+    Get a linear form as a number if it is constant, otherwise as a C expression.
+    EXAMPLE:
+        ({"P": 1}, -1) -> "P - 1"
+    '''
+    terms, constant = a
+    if not terms:
+        return constant
+    expr = ""
+    for term, factor in terms.items():
+        text = term if abs(factor) == 1 else f"{abs(factor)} * {term}"
+        if not expr:
+            expr = text if factor > 0 else f"-{text}"
+        else:
+            expr += f" + {text}" if factor > 0 else f" - {text}"
+    if constant:
+        expr += f" + {constant}" if constant > 0 else f" - {-constant}"
+    return expr
 
-    def get_existing_shared_var(self):
-        return self.existing_shared_var
 
+def get_trip_count(node: c_ast.Node, values: dict) -> tuple:
+    '''
+    Get how often the body of a loop runs as a linear form. Only for loops that count a variable up or down to a
+    bound and while loops that count down a variable with a known value (values) are folded, any other loop runs a
+    runtime number of times named after the loop.
+    EXAMPLE:
+        for (i = 0; i < (P) - 1; i++) -> ({"P": 1}, -1)
+        int n = P; while (n--)        -> ({"P": 1}, 0)
+        while (n--)                   -> ({"(while (n--))": 1}, 0)
+    '''
+    generator = c_generator.CGenerator()
+    if isinstance(node, c_ast.While) and isinstance(node.cond, c_ast.UnaryOp) and node.cond.op == 'p--' and \
+       isinstance(node.cond.expr, c_ast.ID) and node.cond.expr.name in values:
+        return values[node.cond.expr.name]
+    if not isinstance(node, c_ast.For):
+        cond = generator.visit(node.cond)
+        return ({f"({'do ' if isinstance(node, c_ast.DoWhile) else ''}while ({cond}))": 1}, 0)
+
+    var = None
+    init = node.init.exprs[-1] if isinstance(node.init, c_ast.ExprList) else node.init
+    init = init.decls[-1] if isinstance(init, c_ast.DeclList) else init
+    if isinstance(init, c_ast.Decl) and init.init is not None:
+        var, start = init.name, init.init
+    elif isinstance(init, c_ast.Assignment) and init.op == '=' and isinstance(init.lvalue, c_ast.ID):
+        var, start = init.lvalue.name, init.rvalue
+
+    step = None
+    if isinstance(node.next, c_ast.UnaryOp) and isinstance(node.next.expr, c_ast.ID) and node.next.expr.name == var:
+        step = {'p++': 1, '++': 1, 'p--': -1, '--': -1}.get(node.next.op)
+    elif isinstance(node.next, c_ast.Assignment) and node.next.op in ['+=', '-='] and \
+         isinstance(node.next.lvalue, c_ast.ID) and node.next.lvalue.name == var:
+        increment = fold_linear(node.next.rvalue)
+        if not increment[0] and increment[1] > 0:
+            step = increment[1] if node.next.op == '+=' else -increment[1]
+
+    if var is not None and step is not None and isinstance(node.cond, c_ast.BinaryOp):
+        op, left, right = node.cond.op, node.cond.left, node.cond.right
+        # Bring the loop variable to the left side (N > i is i < N)
+        if isinstance(right, c_ast.ID) and right.name == var:
+            op = {'<': '>', '<=': '>=', '>': '<', '>=': '<=', '!=': '!='}.get(op)
+            left, right = right, left
+
+        span = None
+        if isinstance(left, c_ast.ID) and left.name == var:
+            if step > 0 and (op in ['<', '<='] or (op == '!=' and step == 1)):
+                span = add_linear(fold_linear(right), fold_linear(start), -1)
+            elif step < 0 and (op in ['>', '>='] or (op == '!=' and step == -1)):
+                span = add_linear(fold_linear(start), fold_linear(right), -1)
+            if span is not None and op in ['<=', '>=']:
+                span = add_linear(span, ({}, 1))
+
+        if span is not None and not span[0]:
+            return ({}, max(0, -(-span[1] // abs(step))))
+        if span is not None and abs(step) == 1:
+            return span
+        if span is not None:
+            return ({f"(({linear_to_c(span)} + {abs(step) - 1}) / {abs(step)})": 1}, 0)
+
+    header = [generator.visit(part) if part is not None else "" for part in [node.init, node.cond, node.next]]
+    return ({f"(for ({'; '.join(header)}))": 1}, 0)
+
+
+# Where the threads are created and joined and the loops that create or join threads
+class ThreadCreationSites():
+    def __init__(self):
+        self.creation_sites = []
+        self.creation_loops = []
+        self.join_sites = []
+        self.join_loops = []
+        # Threads created and joined by main, as linear forms of the trip counts of the loops around the calls
+        self.created = ({}, 0)
+        self.joined = ({}, 0)
+        self.detached = False
+
+
+    def get_published_once(self, write_sites: dict) -> list:
+        '''
+        Get the shared-variables that are only written by main before the first thread is created.
+        pthread_create synchronizes the memory, so the threads see these values without any lock.
+        Returns an empty list if threads are also created outside of main.
+        '''
+        if not self.creation_sites or any(func != 'main' for func, line_no in self.creation_sites):
+            return []
+
+        first_creation = min(line_no for func, line_no in self.creation_sites)
+        published_once = []
+        for shared_var, sites in write_sites.items():
+            # Writes in a loop that creates threads could happen after the first thread is created
+            if all(func == 'main' and line_no < first_creation and \
+                   not any(loop_func == func and first <= line_no <= last for loop_func, first, last in self.creation_loops) \
+                   for func, line_no in sites):
+                published_once.append(shared_var)
+        return published_once
+
+
+    def is_single_threaded(self, line_no: int) -> bool:
+        '''
+        Check if a line of main can only run while main is the only thread: before the first thread is created
+        or after the last pthread_join. Lines in a loop that creates or joins threads could run in between.
+        The lines after the last pthread_join are only single-threaded if main joins at least as many threads as it
+        creates, both counted as constants or as the same runtime expression, and no thread is detached.
+        '''
+        if not self.creation_sites or any(func != 'main' for func, site in self.creation_sites):
+            return False
+        if any(func == 'main' and first <= line_no <= last for func, first, last in self.creation_loops + self.join_loops):
+            return False
+
+        if line_no < min(site for func, site in self.creation_sites):
+            return True
+        joins = [site for func, site in self.join_sites if func == 'main']
+        not_joined = add_linear(self.created, self.joined, -1)
+        return not self.detached and bool(joins) and max(joins) > max(site for func, site in self.creation_sites) and \
+               line_no > max(joins) and not not_joined[0] and not_joined[1] <= 0
+
+
+    def get_single_threaded_sites(self, auto_sync_calls: dict, call_sites: dict, call_graph: dict, existing_threads: list) -> list:
+        '''
+        Get the AutoSync calls that can only run while main is the only thread. These are the calls in the single-threaded
+        lines of main and in the functions that are only called from there. A ReadToUpdate and its Update must both be
+        single-threaded, otherwise the Update would unlock a mutex that was not locked.
+        Returns an empty list if threads are also created outside of main.
+        EXAMPLE:
+            ["286", "287", "505"]
+        '''
+        # Functions that run in the threads or while the threads run
+        concurrent_funcs = get_reachable({thread for thread in existing_threads if thread != 'main'} | \
+                                         {callee for line_no, callee in call_graph.get('main', []) if not self.is_single_threaded(line_no)},
+                                         call_graph)
+        if "" in concurrent_funcs:
+            # A call through a function pointer could call any function
+            concurrent_funcs |= set(call_graph.keys())
+        single_threaded_funcs = get_reachable({callee for line_no, callee in call_graph.get('main', []) \
+                                               if self.is_single_threaded(line_no)}, call_graph) - concurrent_funcs - {'main'}
+
+        sites = []
+        for line_no, func_call in auto_sync_calls.items():
+            if func_call[0] not in [READ_SHARED_VAR, WRITE_SHARED_VAR, READ_TO_UPDATE_SHARED_VAR, UPDATE_SHARED_VAR]:
+                continue
+            func = call_sites[line_no]
+            if (func == 'main' and self.is_single_threaded(get_site_line(line_no))) or func in single_threaded_funcs:
+                sites.append(line_no)
+
+        # The Update of a ReadToUpdate is the next Update of the same shared-variable in the same function
+        next_update = {}
+        for line_no in sorted(auto_sync_calls, key=get_site_order, reverse=True):
+            func_call = auto_sync_calls[line_no]
+            if func_call[0] == UPDATE_SHARED_VAR:
+                next_update[(func_call[1], call_sites[line_no])] = line_no
+            elif func_call[0] == READ_TO_UPDATE_SHARED_VAR:
+                update = next_update.get((func_call[1], call_sites[line_no]))
+                if update is not None and (line_no in sites) != (update in sites):
+                    sites = [site for site in sites if site not in [line_no, update]]
+
+        return sorted(sites, key=get_site_order)
+
+
+# Get all the information of the static analysis with a single traversal of the AST
+class StaticAnalysisVisitor(c_ast.NodeVisitor):
+    def __init__(self):
+        # main should always exist and is not created with pthread_create
+        self.existing_threads = ['main']
+        self.existing_var = {}
+        self.decl_count = {}
+        self.event_barriers = {}
+        self.intention_decls = {}
+        self.shared_var_usage = {}
+        self.auto_sync_calls = {}
+        self.array_indexes = {}
+        self.intentions = {}
+        self.call_graph = {}
+        self.thread_ids = {}
+        self.thread_sites = ThreadCreationSites()
+        self.thread_instances = []
+        self.main_calls = []
+        self.func = None
+        self.decl_depth = 0
+        self.loops = []
+        # Linear forms of the local variables, while they keep the value of their declaration
+        self.values = {}
+
+
+    def visit(self, node):
+        # Every node of a loop extends the range of lines of the loop
+        if self.loops and node.coord is not None:
+            loop = self.loops[-1]
+            loop["First"] = min(loop["First"], int(node.coord.line))
+            loop["Last"] = max(loop["Last"], int(node.coord.line))
+        return super().visit(node)
 
-    def show(self):
-        print(self.existing_shared_var)
 
-# Get coupled variables
-class IntentionsVisitor(c_ast.NodeVisitor):
-    def __init__(self, intention_var):       
-        self.intention_var = intention_var
-        self.depends_on = []
-        self.constant_init_by_main = []
+    def visit_FuncDef(self, node):
+        self.func = node.decl.name
+        self.calls = []
+        self.copies = []
+        self.assignments = {}
+        self.values = {}
+        self.shared_var_usage[self.func] = {"Read": list(),
+                                            "Write": list(),
+                                            "ReadToUpdate": list(),
+                                            "Update": list(),
+                                            "Reduce": list(),
+                                            "Enqueue": list(),
+                                            "Dequeue": list(),
+                                            "Quantity": 0}
+        self.generic_visit(node)
+
+        self.call_graph[self.func] = self.calls
+        # The copy must be the only assignment of the variable in the function
+        self.thread_ids[self.func] = del_duplicates([var for var in self.copies if self.assignments.get(var, 0) == 1])
+        self.func = None
 
 
     def visit_Decl(self, node):
-        for var in self.intention_var:  
-                
-            if var == node.name:
-                if "xIntentionRootN" in self.intention_var:
-                    pass
-                    #embed()
-                if node.init is None:
-                    print(f"!!! [PARSER INFO] No intention has been specified for {node.name}")
-                else:
-                    # Iterate over all fields in the xAutoSyncIntentions struct 
-                    for intention in node.init.exprs:
-                        if intention.name[0].name == "pvDependsOn":                            
-                            if isinstance(intention.expr.expr, c_ast.StructRef):
-                                dependent_var = intention.expr.expr.name.name + \
-                                                intention.expr.expr.type + \
-                                                intention.expr.expr.field.name
-                            elif isinstance(intention.expr.expr, c_ast.ID):
-                                dependent_var = intention.expr.expr.name
-                            else:
-                                print(f'[PARSE ERROR] Could not read shared-variable dependency: {intention}')
-                                exit(1)
-                            
-                            self.depends_on.append(dependent_var)
-                        elif intention.name[0].name == "bConstantInitByMain":
-                            if intention.expr.value == '1':
-                                # Flag is set to true
-                                self.constant_init_by_main.append("bConstantInitByMain") 
-                    
-
-    def get_dependecies(self):
-        self.depends_on = del_duplicates(self.depends_on)
-        return self.depends_on
-
-
-    def get_constant_init_by_main(self):
-        self.constant_init_by_main = del_duplicates(self.constant_init_by_main)
-        return self.constant_init_by_main
-
-
-
-# Get the existing local and global variables and their types
-class VarDeclVisitor(c_ast.NodeVisitor):
-    def __init__(self):       
-        self.existing_var = {}
-
-
-    def visit_Decl(self, node):        
-        if isinstance(node.type, c_ast.TypeDecl):
+        if node.name is not None:
+            self.decl_count[node.name] = self.decl_count.get(node.name, 0) + 1
+
+        # The declarations inside other declarations (e.g. fields of structs, parameters) are not variables
+        if self.decl_depth == 0:
+            self.add_var_decl(node)
+            self.add_event_decl(node)
+            if node.name is not None:
+                self.intention_decls.setdefault(node.name, []).append(node)
+            if self.func is not None and node.name is not None:
+                self.values.pop(node.name, None)
+                if isinstance(node.type, c_ast.TypeDecl) and node.init is not None and not isinstance(node.init, c_ast.InitList):
+                    self.values[node.name] = fold_linear(node.init)
+
+        self.decl_depth += 1
+        self.generic_visit(node)
+        self.decl_depth -= 1
+
+
+    def add_var_decl(self, node):
+        # Get the existing local and global variables and their types
+        if isinstance(node.type, c_ast.TypeDecl) and isinstance(node.type.type, c_ast.IdentifierType):
             self.existing_var[node.name] = ' '.join(node.type.type.names)
+        elif isinstance(node.type, c_ast.TypeDecl) and isinstance(node.type.type, c_ast.Struct):
+            # Local structs of the libraries, e.g. struct timespec
+            self.existing_var[node.name] = f'struct {node.type.type.name}'
         elif isinstance(node.type, c_ast.ArrayDecl):
             arr_name = node.name
             if isinstance(node.type.type.type, c_ast.IdentifierType):
-                arr_type = node.type.type.type.names                
+                arr_type = node.type.type.type.names
             elif isinstance(node.type.type.type, c_ast.TypeDecl):
                 arr_type = node.type.type.type.type.names
             arr_size = node.type.dim.value
             self.existing_var[f'{arr_name}[{arr_size}]'] = ' '.join(arr_type)
 
 
-    def get_existing_var(self):
-        return self.existing_var
-
-
-    def show(self):
-        print(self.existing_var)
-
-
-# Get the existing shared-variables 
-class SharedVarUsageVisitor(c_ast.NodeVisitor):
-    def __init__(self, existing_threads):        
-        # main should always exist and is not created with pthread_create
-        self.shared_var_usage = []
-        self.existing_threads = existing_threads
-
-
-    def visit_FuncDef(self, node):
-        # Function Name: node.decl.name
-        for thread in existing_threads:
-            if node.decl.name == thread:
-                v = FuncCallVisitor(thread)
-                v.visit(node)  
-
-
-class FuncCallVisitor(c_ast.NodeVisitor):
-    def __init__(self, thread):        
-        self.callees = []  
-        self.thread = thread
-        shared_var_usage[self.thread] = {"Read": list(), 
-                                         "Write": list(),
-                                         "ReadToUpdate": list(),
-                                         "Update": list(),
-                                         "Quantity": 0}        
+    def add_event_decl(self, node):
+        # Get the barrier algorithm selected for each event
+        if isinstance(node.type, c_ast.TypeDecl) and \
+           isinstance(node.type.type, c_ast.IdentifierType) and \
+           node.type.type.names == [EVENT_TYPE]:
+            if node.init is None:
+                self.event_barriers[node.name] = BARRIER_DEFAULT
+            elif isinstance(node.init, c_ast.ID):
+                self.event_barriers[node.name] = node.init.name
+            else:
+                print(f'[PARSE ERROR] Barrier of event {node.name} could not be recognized: {node.init}')
+                exit(1)
+
+
+    def visit_loop(self, node):
+        self.loops.append({"First": int(node.coord.line), "Last": int(node.coord.line), "Callees": set(),
+                           "Trips": get_trip_count(node, self.values)})
+        self.generic_visit(node)
+        loop = self.loops.pop()
+
+        if FUNC_CREATE_TASK in loop["Callees"]:
+            self.thread_sites.creation_loops.append((self.func, loop["First"], loop["Last"]))
+        if FUNC_JOIN_TASK in loop["Callees"]:
+            self.thread_sites.join_loops.append((self.func, loop["First"], loop["Last"]))
+
+        # The enclosing loop contains everything of this loop
+        if self.loops:
+            self.loops[-1]["First"] = min(self.loops[-1]["First"], loop["First"])
+            self.loops[-1]["Last"] = max(self.loops[-1]["Last"], loop["Last"])
+            self.loops[-1]["Callees"] |= loop["Callees"]
+
+
+    visit_For = visit_loop
+    visit_While = visit_loop
+    visit_DoWhile = visit_loop
+
+
+    def visit_Compound(self, node):
+        # Get the local variables that hold a different value in every thread (i.e. thread ids)
+        # Pattern: the value of a shared counter is copied before the counter is incremented
+        #     iAutoSyncReadToUpdate(&NewId, &Global->id, sizeof(NewId), xNoSpecialIntention);
+        #     MyNum = NewId;
+        #     NewId++;
+        #     iAutoSyncUpdate(&Global->id, &NewId, sizeof(NewId), xNoSpecialIntention);
+        local_var = None
+        copies = []
+        incremented = False
+
+        for item in node.block_items or []:
+            if isinstance(item, c_ast.FuncCall) and isinstance(item.name, c_ast.ID) and \
+               item.name.name == READ_TO_UPDATE_SHARED_VAR:
+                arg = item.args.exprs[0]
+                local_var = arg.expr.name if isinstance(arg, c_ast.UnaryOp) and isinstance(arg.expr, c_ast.ID) else None
+                copies = []
+                incremented = False
+            elif local_var is None:
+                continue
+            elif isinstance(item, c_ast.FuncCall) and isinstance(item.name, c_ast.ID) and \
+                 item.name.name == UPDATE_SHARED_VAR:
+                if incremented:
+                    self.copies += copies
+                local_var = None
+            elif isinstance(item, c_ast.Assignment) and item.op == '=' and not incremented and \
+                 isinstance(item.lvalue, c_ast.ID) and isinstance(item.rvalue, c_ast.ID) and \
+                 item.rvalue.name == local_var:
+                copies.append(item.lvalue.name)
+            elif isinstance(item, c_ast.UnaryOp) and item.op in ['p++', '++'] and \
+                 isinstance(item.expr, c_ast.ID) and item.expr.name == local_var:
+                incremented = True
+            else:
+                local_var = None
+
+        self.generic_visit(node)
+
+
+    def visit_Assignment(self, node):
+        if self.func is not None and isinstance(node.lvalue, c_ast.ID):
+            self.assignments[node.lvalue.name] = self.assignments.get(node.lvalue.name, 0) + 1
+            self.values.pop(node.lvalue.name, None)
+        self.generic_visit(node)
+
+
+    def visit_UnaryOp(self, node):
+        # Taking the address also counts, the variable could be modified through the pointer
+        if self.func is not None and node.op in ['p++', '++', 'p--', '--', '&'] and isinstance(node.expr, c_ast.ID):
+            self.assignments[node.expr.name] = self.assignments.get(node.expr.name, 0) + 1
+            self.values.pop(node.expr.name, None)
+        self.generic_visit(node)
 
 
     def visit_FuncCall(self, node):
-        self.callees.append(node.name.name)
-        line_no = int(node.coord.line) 
-        func = node.name.name
-
-        if func == READ_SHARED_VAR:
-            #if isinstance(node.args.exprs[1].expr, c_ast.StructRef):
-            #    shared_var = node.args.exprs[1].expr.name.name + \
-            #                 node.args.exprs[1].expr.type + \
-            #                 node.args.exprs[1].expr.field.name
-            #elif isinstance(node.args.exprs[1], c_ast.ID):
-                # Handle cases where the pointer is passed directly (without &)
-            #    shared_var = node.args.exprs[1].name
-            #else:
-            #    shared_var = node.args.exprs[1].expr.name            
-            shared_var = get_shared_var_from_auto_sync_call(node)
-            shared_var_usage[self.thread]["Read"].append(shared_var)
-            auto_sync_calls[line_no] = (READ_SHARED_VAR, shared_var)
-        
-            if shared_var not in intentions:
-                intentions[shared_var] = []
-            intentions[shared_var].append(node.args.exprs[3].name)
-
-        if func == READ_TO_UPDATE_SHARED_VAR:         
-            #if isinstance(node.args.exprs[1], c_ast.ID):
-                # Handle cases where the pointer is passed directly (without &)
-            #    shared_var = node.args.exprs[1].name   
-            #elif isinstance(node.args.exprs[1].expr, c_ast.StructRef):
-            #    shared_var = node.args.exprs[1].expr.name.name + \
-            #                 node.args.exprs[1].expr.type + \
-            #                 node.args.exprs[1].expr.field.name            
-            #else:
-            #    shared_var = node.args.exprs[1].expr.name            
-            shared_var = get_shared_var_from_auto_sync_call(node)
-            shared_var_usage[self.thread]["ReadToUpdate"].append(shared_var)
-            auto_sync_calls[line_no] = (READ_TO_UPDATE_SHARED_VAR, shared_var)
-            
-            if shared_var not in intentions:
-                intentions[shared_var] = []
-            intentions[shared_var].append(node.args.exprs[3].name)     
-             
-            
-        if func == WRITE_SHARED_VAR:
-            #if isinstance(node.args.exprs[0], c_ast.ID):
-                # Handle cases where the pointer is passed directly (without &)
-            #    shared_var = node.args.exprs[0].name
-            #elif isinstance(node.args.exprs[0].expr, c_ast.StructRef):
-            #    shared_var = node.args.exprs[0].expr.name.name + \
-            #                 node.args.exprs[0].expr.type + \
-            #                 node.args.exprs[0].expr.field.name
-            #else:
-            #    shared_var = node.args.exprs[0].expr.name            
+        # Calls through function pointers have no name, they could call any function
+        callee = node.name.name if isinstance(node.name, c_ast.ID) else ""
+        if self.loops:
+            self.loops[-1]["Callees"].add(callee)
+
+        # A call runs as often as the loops around it
+        instances = ({}, 1)
+        for loop in self.loops:
+            instances = mul_linear(instances, loop["Trips"])
+        if self.func == 'main':
+            self.main_calls.append((callee, instances))
+
+        if callee == FUNC_CREATE_TASK:
+            self.existing_threads.append(node.args.exprs[2].expr.name)
+            if self.func != 'main':
+                # The function that creates the thread could run any number of times
+                instances = mul_linear(instances, ({f"(calls of {self.func})": 1}, 0))
+            self.thread_instances.append((node.args.exprs[2].expr.name, instances))
+            self.thread_sites.creation_sites.append((self.func, int(node.coord.line)))
+            if self.func == 'main':
+                self.thread_sites.created = add_linear(self.thread_sites.created, instances)
+        elif callee == FUNC_JOIN_TASK:
+            self.thread_sites.join_sites.append((self.func, int(node.coord.line)))
+            if self.func == 'main':
+                self.thread_sites.joined = add_linear(self.thread_sites.joined, instances)
+        elif callee == FUNC_DETACH_TASK:
+            self.thread_sites.detached = True
+
+        if self.func is not None:
+            self.calls.append((int(node.coord.line), callee))
+            self.add_auto_sync_call(node, callee)
+
+        self.generic_visit(node)
+
+
+    def add_auto_sync_call(self, node, func):
+        line_no = int(node.coord.line)
+        if line_no in self.auto_sync_calls:
+            line_no = f"{line_no}:{node.coord.column}"
+
+        if func in [READ_SHARED_VAR, WRITE_SHARED_VAR, READ_TO_UPDATE_SHARED_VAR, UPDATE_SHARED_VAR]:
+            self.array_indexes[line_no] = (self.func, get_array_index_from_auto_sync_call(node))
+
             shared_var = get_shared_var_from_auto_sync_call(node)
-            shared_var_usage[self.thread]["Write"].append(shared_var)
-            auto_sync_calls[line_no] = (WRITE_SHARED_VAR, shared_var)
-
-            if shared_var not in intentions:
-                intentions[shared_var] = []
-            intentions[shared_var].append(node.args.exprs[3].name)  
-
-        if func == UPDATE_SHARED_VAR:
-            #if isinstance(node.args.exprs[0], c_ast.ID):
-                # Handle cases where the pointer is passed directly (without &)
-            #    shared_var = node.args.exprs[0].name
-            #elif isinstance(node.args.exprs[0].expr, c_ast.StructRef):
-            #    shared_var = node.args.exprs[0].expr.name.name + \
-            #                 node.args.exprs[0].expr.type + \
-            #                 node.args.exprs[0].expr.field.name
-            #else:
-            #    shared_var = node.args.exprs[0].expr.name            
+            usage = {READ_SHARED_VAR: "Read", WRITE_SHARED_VAR: "Write",
+                     READ_TO_UPDATE_SHARED_VAR: "ReadToUpdate", UPDATE_SHARED_VAR: "Update"}[func]
+            self.shared_var_usage[self.func][usage].append(shared_var)
+            self.auto_sync_calls[line_no] = (func, shared_var)
+            self.intentions.setdefault(shared_var, []).append(node.args.exprs[3].name)
+
+        if func == REDUCE_SHARED_VAR:
             shared_var = get_shared_var_from_auto_sync_call(node)
-            shared_var_usage[self.thread]["Update"].append(shared_var)
-            auto_sync_calls[line_no] = (UPDATE_SHARED_VAR, shared_var)  
+            reduce_op = node.args.exprs[3].name
+            self.shared_var_usage[self.func]["Reduce"].append(shared_var)
+            self.auto_sync_calls[line_no] = (REDUCE_SHARED_VAR, shared_var, reduce_op)
+            self.intentions.setdefault(shared_var, []).append(node.args.exprs[4].name)
 
-            if shared_var not in intentions:
-                intentions[shared_var] = []
-            intentions[shared_var].append(node.args.exprs[3].name)        
+        if func in [ENQUEUE, DEQUEUE]:
+            queue = get_shared_var_from_auto_sync_call(node)
+            self.shared_var_usage[self.func]["Enqueue" if func == ENQUEUE else "Dequeue"].append(queue)
+            self.auto_sync_calls[line_no] = (func, queue)
+            self.intentions.setdefault(queue, []).append(node.args.exprs[3].name)
 
         if func == PROCEED_ON_EVENT:
-           
             event = node.args.exprs[0].name
             no_of_threads = node.args.exprs[1].name
-            auto_sync_calls[line_no] = (PROCEED_ON_EVENT, event, no_of_threads)  
-        
-        # Visit args in case they contain more func calls.
-        if node.args:
-            self.visit(node.args)
-
-    def get_auto_sync_read_usage(self):
-        return self.auto_sync_read 
-
-def show_func_calls(ast, funcname):    
-    v = FuncCallVisitor(funcname)
-    v.visit(ast)  
-    
-    
-def get_existing_threads(ast) -> list:    
-    v = ThreadCreationVisitor()
-    v.visit(ast)
-    return v.get_existing_threads()
-
-def get_no_of_threads(ast, existing_threads) -> dict:
-    v = NoOfThreadsVisitor(existing_threads)
-    v.visit(ast)
-    return v.no_of_threads
-
-
-def get_existing_shared_var(ast) -> list:    
-    v = SharedVarVisitor()
-    v.visit(ast)
-    return set(v.get_existing_shared_var())
-
-
-def get_shared_var_usage(ast, existing_threads) -> list:    
-    v = SharedVarUsageVisitor(existing_threads)
-    v.visit(ast)
-    #return set(v.get_existing_shared_var())
+            self.auto_sync_calls[line_no] = (PROCEED_ON_EVENT, event, no_of_threads)
+
+
+    def get_summary(self, ast) -> dict:
+        '''
+        Get the tables of the static analysis of the translation unit. The lines are the lines of its file.
+        '''
+        # Intentions declared here could be used by other units
+        intention_vars = [name for name, nodes in self.intention_decls.items() \
+                          if any(isinstance(node.type, c_ast.TypeDecl) and isinstance(node.type.type, c_ast.IdentifierType) and \
+                                 node.type.type.names == [INTENTIONS_TYPE] for node in nodes)]
+        intention_vars = del_duplicates(intention_vars + [name for names in self.intentions.values() for name in names])
+        return {"SharedVarUsage": self.shared_var_usage,
+                "ExistingVar": self.existing_var,
+                "AutoSyncCalls": self.auto_sync_calls,
+                "Intentions": self.intentions,
+                "IntentionDecls": {name: self.get_intention(name) for name in intention_vars},
+                "EventBarriers": self.event_barriers,
+                "ArrayIndexes": self.array_indexes,
+                "CallGraph": self.call_graph,
+                "GlobalVars": self.get_global_vars(ast),
+                "DeclCount": self.decl_count,
+                "ThreadIds": self.thread_ids,
+                "ExistingThreads": self.existing_threads,
+                "ThreadInstances": self.thread_instances,
+                "MainCalls": self.main_calls,
+                "ThreadSites": vars(self.thread_sites)}
+
+
+    def get_global_vars(self, ast) -> dict:
+        '''
+        Get the global variables that can be moved into a struct (i.e. no other declaration has the same name).
+        Returns a dictionary with the line and the type of the global variables with a basic type.
+        EXAMPLE:
+            "uiCountOccurrences": {"Line": 17, "Type": "uint32_t"}
+        '''
+        global_vars = {}
+        for node in ast.ext:
+            if isinstance(node, c_ast.Decl) and isinstance(node.type, c_ast.TypeDecl) and \
+               isinstance(node.type.type, c_ast.IdentifierType) and not node.storage and \
+               self.decl_count.get(node.name, 0) == 1:
+                global_vars[node.name] = {"Line": int(node.coord.line), "Type": ' '.join(node.type.type.names)}
+        return global_vars
+
+
+    def get_intention(self, intention_var: str) -> tuple:
+        '''
+        Read the declaration of an xAutoSyncIntentions variable.
+        Returns the shared-variables it depends on, its flags, the accessed range of a sliced array, if any
+        declaration initializes it (an extern declaration does not) and the capacity of a queue (0 if not given).
+        EXAMPLE:
+            xIntentionTransTimes -> (["P"], ["bSlicedArray"], {"FirstAccess": 0, "LastAccess": 0}, True, 0)
+        '''
+        depends_on = []
+        flags = []
+        sliced_array = {"FirstAccess": 0, "LastAccess": 0}
+        specified = False
+        capacity = 0
+
+        for node in self.intention_decls.get(intention_var, []):
+            if node.init is None:
+                continue
+            specified = True
+
+            # Iterate over all fields in the xAutoSyncIntentions struct
+            for intention in node.init.exprs:
+                if intention.name[0].name == "pvDependsOn":
+                    if isinstance(intention.expr.expr, c_ast.StructRef):
+                        dependent_var = intention.expr.expr.name.name + \
+                                        intention.expr.expr.type + \
+                                        intention.expr.expr.field.name
+                    elif isinstance(intention.expr.expr, c_ast.ID):
+                        dependent_var = intention.expr.expr.name
+                    else:
+                        print(f'[PARSE ERROR] Could not read shared-variable dependency: {intention}')
+                        exit(1)
+                    depends_on.append(dependent_var)
+                elif intention.name[0].name in ["bConstantInitByMain", "bOptimisticRead", "bSlicedArray", "bDeferredUpdate",
+                                                "bSingleProducer", "bSingleConsumer"]:
+                    if intention.expr.value == '1':
+                        # Flag is set to true
+                        flags.append(intention.name[0].name)
+                elif intention.name[0].name == "uiFirstAccess":
+                    sliced_array["FirstAccess"] = get_constant_value(intention.expr)
+                elif intention.name[0].name == "uiLastAccess":
+                    sliced_array["LastAccess"] = get_constant_value(intention.expr)
+                elif intention.name[0].name == "uiQueueCapacity":
+                    capacity = get_constant_value(intention.expr)
+
+        # The range of accessed elements is only meaningful if bSlicedArray is set
+        if "bSlicedArray" not in flags:
+            sliced_array = {}
+        return del_duplicates(depends_on), del_duplicates(flags), sliced_array, specified, capacity
+
+
+def get_no_of_threads(thread_instances: list, main_calls: list) -> dict:
+    '''
+    Get the quantity of instances of each existing thread: the threads created by every pthread_create, multiplied
+    by the trip counts of the loops around it. A thread function that main also calls directly has one more
+    instance. The quantity is a number if it could be constant-folded, otherwise the C expression of the runtime
+    values it depends on.
+    EXAMPLE:
+        for (i = 0; i < (P) - 1; i++) pthread_create(..., SlaveStart, ...); SlaveStart(); -> "SlaveStart": "P"
+    '''
+    instances = {'main': ({}, 1)}
+    for thread, thread_instances in thread_instances:
+        instances[thread] = add_linear(instances.get(thread, ({}, 0)), thread_instances)
+    for callee, call_instances in main_calls:
+        if callee in instances and callee != 'main':
+            instances[callee] = add_linear(instances[callee], call_instances)
+    return {thread: linear_to_c(thread_instances) for thread, thread_instances in instances.items()}
 
-# Why do we need this?
-# The FuncCallVisitor is only able to detect the calls "in the first level"
-# If we have an AutoSync call inside another function, this is not detected.
-# That's why we need this FuncDefVisitor
-class FuncDefVisitor(c_ast.NodeVisitor):
-    def __init__(self):    
-        pass    
 
-    def visit_FuncDef(self, node):
-        try:
-            line_no = int(node.coord.line) 
-            func = node.decl.name
-
-            if func == PROCEED_ON_EVENT:
-                event = node.args.exprs[0].name
-                no_of_threads = node.args.exprs[1].name
-                auto_sync_calls[line_no] = (PROCEED_ON_EVENT, event, no_of_threads)
-
-            if func == UPDATE_SHARED_VAR:  
-                embed()       
-                shared_var = get_shared_var_from_auto_sync_call(node)
-                shared_var_usage[self.thread]["Update"].append(shared_var)
-                auto_sync_calls[line_no] = (UPDATE_SHARED_VAR, shared_var)  
-
-                if shared_var not in intentions:
-                    intentions[shared_var] = []
-                intentions[shared_var].append(node.args.exprs[3].name)         
-            
-            v = FuncCallVisitor(node.decl.name)
-            v.visit(node)
-        except Exception as ex:
-            print(f'Exception when visiting Function Definitions: {ex}')
-            embed()
-      
+def get_queue_ends(queue: str, access: str, existing_threads: list) -> object:
+    '''
+    Get the quantity of threads that enqueue (or dequeue) items of a queue: the instances of every thread that calls
+    iAutoSyncEnqueue (or iAutoSyncDequeue) itself or in a function it calls. main does not reach the threads it calls
+    directly, their instances already count these calls. The quantity is a number if it could be constant-folded,
+    otherwise the C expression of the runtime values it depends on.
+    EXAMPLE:
+        "xWorkQueue", "Enqueue", ["main", "Producer", "Consumer"] -> 1
+    '''
+    funcs = {func for func, usage in shared_var_usage.items() if queue in usage[access]}
+    quantities = []
+    for thread in del_duplicates(existing_threads):
+        reachable = get_reachable({thread}, call_graph, set(existing_threads) - {thread})
+        # A call through a function pointer could call any function
+        if reachable & funcs or "" in reachable:
+            quantities.append(shared_var_usage[thread]["Quantity"])
 
+    if all(isinstance(quantity, int) for quantity in quantities):
+        return sum(quantities)
+    return " + ".join(str(quantity) for quantity in quantities)
 
 
-if __name__ == "__main__":
-    filename  = sys.argv[1]   
+def get_cache_key(filename: str) -> str:
+    '''
+    Get the hash of everything the summary of a translation unit depends on: the parser, the file and the local
+    headers it includes with "...". The headers of the system are not part of the key.
+    '''
+    key = hashlib.sha256()
+    with open(__file__, "rb") as parser:
+        key.update(parser.read())
+
+    pending = [filename]
+    visited = set()
+    while pending:
+        path = os.path.normpath(pending.pop())
+        if path in visited or not os.path.isfile(path):
+            continue
+        visited.add(path)
+        with open(path, "rb") as file:
+            content = file.read()
+        key.update(path.encode() if path != os.path.normpath(filename) else b"")
+        key.update(content)
+        for header in re.findall(rb'^\s*#\s*include\s*"([^"]+)"', content, re.MULTILINE):
+            pending.append(os.path.join(os.path.dirname(path), header.decode()))
+    return key.hexdigest()
+
+
+def analyse_translation_unit(filename: str) -> dict:
+    '''
+    Parse a translation unit and get the summary of its static analysis.
+    Returns None if the analysis failed, the error has already been printed.
+    '''
     print(f'MATHEUS: {filename}')
-    ast = parse_file(filename, use_cpp=True,
-                               cpp_path='gcc',
-                               cpp_args=['-E', r'-Iutils/fake_libc_include'])
-    
-    g = VarDeclVisitor()
-    g.visit(ast)
-    existing_var = g.get_existing_var()
-    #g.show()
+    try:
+        ast = parse_file(filename, use_cpp=True,
+                                   cpp_path='gcc',
+                                   cpp_args=['-E', r'-Iutils/fake_libc_include'])
+        v = StaticAnalysisVisitor()
+        v.visit(ast)
+        # The summary is stored as JSON, so it has the same types whether it was cached or not
+        return json.loads(json.dumps(v.get_summary(ast)))
+    except SystemExit:
+        # exit(1) of a worker process would leave the other processes waiting for its result
+        return None
 
-    t = FuncDefVisitor()
-    t.visit(ast)
-            
-    # Print information obtained with static analysis
-    existing_threads = get_existing_threads(ast)
-    no_of_threads = get_no_of_threads(ast, existing_threads)
-    existing_shared_var = get_existing_shared_var(ast)
-    
-    get_shared_var_usage(ast, existing_threads)
 
-    #print(f'Existing threads: {set(existing_threads)}\n')
-    #print(f'Quantity of each thread: {no_of_threads}\n')
-    #print(f'Existing shared-variables: {set(existing_shared_var)}\n')
-    #print(f'Usage of shared-variables: {shared_var_usage}\n')
+def get_unit_summaries(filenames: list, jobs: int, cache_dir: str) -> list:
+    '''
+    Get the summary of every translation unit. Units whose content did not change since the last run are read from
+    the cache, the other ones are parsed in parallel and added to the cache.
+    '''
+    summaries = [None] * len(filenames)
+    keys = [get_cache_key(filename) for filename in filenames]
+    pending = []
+    for unit, filename in enumerate(filenames):
+        cache_file = os.path.join(cache_dir, f"{keys[unit]}.json") if cache_dir else None
+        if cache_file and os.path.isfile(cache_file):
+            print(f"!!! [PARSER INFO] {filename} did not change, its cached analysis is used")
+            with open(cache_file, "r") as cache:
+                summaries[unit] = json.load(cache)
+        else:
+            pending.append(unit)
 
+    if len(pending) > 1 and jobs > 1:
+        with multiprocessing.Pool(min(jobs, len(pending))) as pool:
+            results = pool.map(analyse_translation_unit, [filenames[unit] for unit in pending])
+    else:
+        results = [analyse_translation_unit(filenames[unit]) for unit in pending]
+
+    for unit, summary in zip(pending, results):
+        if summary is None:
+            print(f'[PARSER ERROR] Static analysis of {filenames[unit]} failed!')
+            exit(1)
+        summaries[unit] = summary
+        if cache_dir:
+            os.makedirs(cache_dir, exist_ok=True)
+            # Written under a temporary name first, a concurrent run never reads half a summary
+            cache_file = os.path.join(cache_dir, f"{keys[unit]}.json")
+            with open(f"{cache_file}.{os.getpid()}", "w") as cache:
+                json.dump(summary, cache)
+            os.replace(f"{cache_file}.{os.getpid()}", cache_file)
+    return summaries
+
+
+def link_translation_units(filenames: list, summaries: list) -> tuple:
+    '''
+    Merge the summaries of the translation units into the tables of the program. The lines of every unit are moved
+    behind the lines of the previous units, so that a line identifies one AutoSync call of the program. Functions
+    with the same name in several units are merged. A global variable is only moved into a struct if no other unit
+    declares it.
+    Returns the existing variables, the global variables, the existing threads, the sites that create and join threads
+    and the first line of every unit.
+    EXAMPLE:
+        units: [["main.c", 0], ["worker.c", 160]]
+    '''
+    existing_var = {}
+    global_vars = {}
+    existing_threads = []
+    thread_sites = ThreadCreationSites()
+    thread_instances = []
+    main_calls = []
+    intention_decls = {}
+    units = []
+
+    offset = 0
+    for filename, summary in zip(filenames, summaries):
+        units.append([filename, offset])
+
+        for func, usage in summary["SharedVarUsage"].items():
+            merged = shared_var_usage.setdefault(func, {access: 0 if access == "Quantity" else list() for access in usage})
+            for access, accesses in usage.items():
+                if access != "Quantity":
+                    merged[access] += accesses
+        for func, calls in summary["CallGraph"].items():
+            call_graph.setdefault(func, []).extend([(int(line_no) + offset, callee) for line_no, callee in calls])
+        for func, ids in summary["ThreadIds"].items():
+            thread_ids[func] = del_duplicates(thread_ids.get(func, []) + ids)
+
+        for line_no, func_call in summary["AutoSyncCalls"].items():
+            auto_sync_calls[shift_site(line_no, offset)] = tuple(func_call)
+        for line_no, (func, index) in summary["ArrayIndexes"].items():
+            array_indexes[shift_site(line_no, offset)] = (func, index)
+        for shared_var, names in summary["Intentions"].items():
+            intentions.setdefault(shared_var, []).extend(names)
+        for name, intention in summary["IntentionDecls"].items():
+            # The unit that initializes the intention has its content, the other ones only declare it
+            if name not in intention_decls or (intention[3] and not intention_decls[name][3]):
+                intention_decls[name] = intention
+
+        existing_var.update(summary["ExistingVar"])
+        event_barriers.update(summary["EventBarriers"])
+        for var, info in summary["GlobalVars"].items():
+            if not any(var in other["DeclCount"] for other in summaries if other is not summary):
+                global_vars[var] = {"Line": info["Line"] + offset, "Type": info["Type"]}
+
+        existing_threads += [thread for thread in summary["ExistingThreads"] if thread != 'main' or 'main' not in existing_threads]
+        thread_instances += summary["ThreadInstances"]
+        main_calls += summary["MainCalls"]
+        sites = summary["ThreadSites"]
+        thread_sites.creation_sites += [(func, line_no + offset) for func, line_no in sites["creation_sites"]]
+        thread_sites.creation_loops += [(func, first + offset, last + offset) for func, first, last in sites["creation_loops"]]
+        thread_sites.join_sites += [(func, line_no + offset) for func, line_no in sites["join_sites"]]
+        thread_sites.join_loops += [(func, first + offset, last + offset) for func, first, last in sites["join_loops"]]
+        thread_sites.created = add_linear(thread_sites.created, sites["created"])
+        thread_sites.joined = add_linear(thread_sites.joined, sites["joined"])
+        thread_sites.detached |= sites["detached"]
+
+        with open(filename, "r") as file:
+            offset += len(file.readlines())
+
+    no_of_threads = get_no_of_threads(thread_instances, main_calls)
     for thread in existing_threads:
         shared_var_usage[thread]["Quantity"] = no_of_threads[thread]
 
-    existing_shared_var = []
-    for thread, info in shared_var_usage.items():
-        for key in info:
-            if key == 'Read' or key == 'Write' or \
-               key == 'ReadToUpdate' or key == 'Update':
-                existing_shared_var.append(info[key])
-
-    if [] in existing_shared_var: existing_shared_var.remove([])
-    existing_shared_var = set(list(flatten(existing_shared_var)))
-
     # Check intentions for plausibility (i.e. check conflicting intentions)
+    # Every intention is read once, no matter how many shared-variables use it
     for key, value in intentions.items():
         intentions_plausible = value.count(value[0]) == len(value)
 
@@ -483,10 +963,63 @@ if __name__ == "__main__":
             print(f'[PARSER ERROR] Shared-variable {key} has conflicting intentions!')
             exit(1)        
     
-        v = IntentionsVisitor(value)
-        v.visit(ast)
-        intentions[key] = v.get_dependecies()
-        general_intentions[key] = v.get_constant_init_by_main()
+        depends_on, flags, sliced_array, specified, capacity = intention_decls.get(value[0], ([], [], {}, True, 0))
+        if not specified:
+            print(f"!!! [PARSER INFO] No intention has been specified for {value[0]}")
+            intention_decls[value[0]][3] = True
+        intentions[key] = list(depends_on)
+        general_intentions[key] = list(flags)
+        if sliced_array:
+            sliced_arrays[key] = dict(sliced_array)
+        if any(key in usage["Enqueue"] + usage["Dequeue"] for usage in shared_var_usage.values()):
+            queues[key] = {"Capacity": capacity}
+
+    return existing_var, global_vars, existing_threads, thread_sites, units
+
+
+if __name__ == "__main__":
+    arg_parser = argparse.ArgumentParser(description="Statically analyse the AutoSync calls of the translation units of a C program")
+    arg_parser.add_argument("paths", nargs="+", help="C files of the program")
+    arg_parser.add_argument("-j", "--jobs", type=int, default=os.cpu_count(),
+                            help="Quantity of translation units parsed in parallel")
+    arg_parser.add_argument("--cache-dir", default=PATH_CACHE,
+                            help="Directory of the cached analysis of every translation unit")
+    arg_parser.add_argument("--no-cache", action="store_true",
+                            help="Parse every translation unit, even if it did not change")
+    args = arg_parser.parse_args()
+
+    summaries = get_unit_summaries(args.paths, args.jobs, None if args.no_cache else args.cache_dir)
+    existing_var, global_vars, existing_threads, c, units = link_translation_units(args.paths, summaries)
+
+    # Shared-variables that are published once by main before the threads are created do not need locks
+    write_sites = {}
+    for line_no, func_call in auto_sync_calls.items():
+        if func_call[0] in [WRITE_SHARED_VAR, READ_TO_UPDATE_SHARED_VAR, UPDATE_SHARED_VAR]:
+            write_sites.setdefault(func_call[1], []).append((array_indexes[line_no][0], get_site_line(line_no)))
+        elif func_call[0] == REDUCE_SHARED_VAR:
+            write_sites.setdefault(func_call[1], []).append((None, get_site_line(line_no)))
+
+    for shared_var in c.get_published_once(write_sites):
+        if shared_var in general_intentions and "bConstantInitByMain" not in general_intentions[shared_var]:
+            print(f"!!! [PARSER INFO] {shared_var} is published once by main before the threads are created")
+            general_intentions[shared_var].append("bPublishedOnce")
+
+    # Calls that run while main is the only thread do not need locks
+    single_threaded_sites = c.get_single_threaded_sites(auto_sync_calls, {line_no: func for line_no, (func, index) in array_indexes.items()},
+                                                        call_graph, existing_threads)
+    if single_threaded_sites:
+        print(f"!!! [PARSER INFO] {len(single_threaded_sites)} AutoSync calls only run while main is the only thread")
+
+    # The cheapest queue is chosen by the quantity of threads on each end
+    for queue, queue_info in queues.items():
+        queue_info["Producers"] = get_queue_ends(queue, "Enqueue", existing_threads)
+        queue_info["Consumers"] = get_queue_ends(queue, "Dequeue", existing_threads)
+
+    # The slices are disjoint if every concurrent access to the array is indexed by the id of the thread
+    for shared_var, sliced_array in sliced_arrays.items():
+        accesses = [array_indexes[line_no] for line_no, func_call in auto_sync_calls.items() \
+                    if func_call[0] != PROCEED_ON_EVENT and func_call[1] == shared_var and line_no not in single_threaded_sites]
+        sliced_array["Disjoint"] = all(index in thread_ids.get(func, []) for func, index in accesses)
         
     print(50*"-")
     parser_output = []
@@ -495,6 +1028,14 @@ if __name__ == "__main__":
     parser_output.append(auto_sync_calls)
     parser_output.append(intentions)
     parser_output.append(general_intentions)    
+    parser_output.append(event_barriers)
+    parser_output.append(sliced_arrays)
+    parser_output.append({line_no: index for line_no, (func, index) in array_indexes.items()})
+    parser_output.append(call_graph)
+    parser_output.append(global_vars)
+    parser_output.append(single_threaded_sites)
+    parser_output.append(units)
+    parser_output.append(queues)
 
     json_file = json.dumps(parser_output, sort_keys=True, indent=2)
     print(json_file)